@@ -0,0 +1,101 @@
+# times melding a document whose shapes share their edges, like the
+# countries of a map, against the same shapes pulled apart:
+#
+#   godot --no-window -s meld.gd
+#
+# shapes sharing edges used to form a single group that melded on one core.
+# they are now cut into groups that meld in parallel, so both documents
+# should take about the same time on a machine with several cores.
+
+extends SceneTree
+
+const RUNS = 5
+const CELLS = 24 # per side
+const CELL_SIZE = 100
+const EDGE_POINTS = 200 # per cell edge
+
+func polyline_path(points):
+	# straight cubic segments, so that flattening keeps every point.
+	var path = PoolVector2Array()
+	path.append(points[0])
+	for i in range(1, points.size()):
+		path.append(points[i - 1])
+		path.append(points[i])
+		path.append(points[i])
+	return path
+
+func edge(a, b):
+	# a wavy edge that only depends on its end points, so that both cells
+	# next to it get exactly the same points.
+	var points = []
+	var normal = (b - a).normalized().tangent()
+	var phase = a.x * 0.37 + a.y * 0.71 + b.x * 0.13 + b.y * 0.29
+	for i in range(EDGE_POINTS):
+		var t = float(i) / EDGE_POINTS
+		var wave = 3.0 * sin(t * PI * 6 + phase) * sin(t * PI)
+		var p = a + (b - a) * t + normal * wave
+		points.append(Vector2(round(p.x), round(p.y)))
+	return points
+
+func corner(x, y):
+	return Vector2(x, y) * CELL_SIZE
+
+func cell(x, y, gap):
+	var c00 = corner(x, y)
+	var c10 = corner(x + 1, y)
+	var c11 = corner(x + 1, y + 1)
+	var c01 = corner(x, y + 1)
+
+	# edges are always built in the same direction and reversed as needed.
+	var points = []
+	points += edge(c00, c10)
+	points += edge(c10, c11)
+	var bottom = edge(c01, c11)
+	bottom.invert()
+	points += bottom
+	var left = edge(c00, c01)
+	left.invert()
+	points += left
+	points.append(points[0])
+
+	if gap > 0:
+		var center = (c00 + c11) * 0.5
+		var s = 1.0 - 2.0 * gap / CELL_SIZE
+		for i in range(points.size()):
+			points[i] = center + (points[i] - center) * s
+	return points
+
+func run(name, gap, meld):
+	var tesselator = Tesselator2D.new()
+	tesselator.meld = meld
+	get_root().add_child(tesselator)
+
+	for y in range(CELLS):
+		for x in range(CELLS):
+			var shape = Bezier2D.new()
+			shape.stroke_width = 0
+			shape.add_path(polyline_path(cell(x, y, gap)))
+			tesselator.add_child(shape)
+
+	var best = -1
+	for i in range(RUNS):
+		tesselator.quality = 100 + 0.001 * (i % 2) # forces a full refresh
+		var t0 = OS.get_ticks_usec()
+		tesselator.tesselate()
+		var t = OS.get_ticks_usec() - t0
+		if best < 0 or t < best:
+			best = t
+
+	var statistics = tesselator.get_statistics()
+	print("%-24s %6d shapes, %8d points, %8.2f ms" % [
+		name, statistics.shapes, statistics.points, best / 1000.0])
+
+	get_root().remove_child(tesselator)
+	tesselator.free()
+
+func _init():
+	print("%d cores" % OS.get_processor_count())
+	run("shared edges, meld", 0, true)
+	run("pulled apart, meld", 5, true)
+	run("shared edges, no meld", 0, false)
+	quit()
@@ -0,0 +1,75 @@
+# stress test for SVG's thread safety: rasterizes one SVG from several
+# threads at once, with every thread taking rasterizers from the shared
+# pool, and checks each result against a serial one:
+#
+#   godot --no-window -s rasterize_threads.gd
+#
+# prints FAILED and exits with 1 on any mismatch.
+
+extends SceneTree
+
+const THREADS = 8
+const ROUNDS = 50
+const SIZE = 256
+
+var svg
+var expected = []
+var failures = 0
+var mutex = Mutex.new()
+
+func write_svg(path):
+	# enough shapes, strokes and gradients to keep the rasterizer busy.
+	var text = '<svg xmlns="http://www.w3.org/2000/svg" width="256" height="256">\n'
+	text += '<defs><radialGradient id="g"><stop offset="0" stop-color="#f80"/><stop offset="1" stop-color="#08f"/></radialGradient></defs>\n'
+	for i in range(64):
+		var x = (i % 8) * 32 + 16
+		var y = (i / 8) * 32 + 16
+		var fill = "url(#g)" if i % 3 == 0 else "#%02x%02x80" % [i * 4, 255 - i * 4]
+		text += '<circle cx="%d" cy="%d" r="%d" fill="%s" stroke="#000" stroke-width="%d"/>\n' % [x, y, 8 + i % 9, fill, 1 + i % 3]
+	text += '</svg>\n'
+
+	var file = File.new()
+	file.open(path, File.WRITE)
+	file.store_string(text)
+	file.close()
+
+func render(scale):
+	var image = svg.rasterize(SIZE, SIZE, 0, 0, scale)
+	return Marshalls.raw_to_base64(image.get_data())
+
+func scale_of(i):
+	return 0.5 + 0.25 * (i % 4) # different sizes use the rasterizers' scratch memory differently
+
+func worker(index):
+	for round_ in range(ROUNDS):
+		var i = index + round_
+		if render(scale_of(i)) != expected[i % 4]:
+			mutex.lock()
+			failures += 1
+			mutex.unlock()
+
+func _init():
+	var path = "user://rasterize_threads.svg"
+	write_svg(path)
+	svg = SVG.new()
+	svg.load(path)
+
+	for i in range(4):
+		expected.append(render(scale_of(i)))
+
+	var t0 = OS.get_ticks_usec()
+	var threads = []
+	for i in range(THREADS):
+		var thread = Thread.new()
+		thread.start(self, "worker", i)
+		threads.append(thread)
+	for thread in threads:
+		thread.wait_to_finish()
+	var t = OS.get_ticks_usec() - t0
+
+	print("%d threads x %d rasterizations, %d mismatches, %.2f ms" % [THREADS, ROUNDS, failures, t / 1000.0])
+	if failures > 0:
+		print("FAILED")
+		quit(1)
+	else:
+		quit()
@@ -0,0 +1,54 @@
+# times the outline simplifier alone on 100k point outlines and reports how
+# many points are kept:
+#
+#   godot --no-window -s simplify.gd
+#
+# only simplify_outline() is timed, which adds a linear copy of the points
+# in and out. flattening and triangulation are not part of it.
+
+extends SceneTree
+
+const RUNS = 3
+const POINTS = 100000
+
+func circle(n, radius):
+	var points = PoolVector2Array()
+	for i in range(n):
+		var a = 2 * PI * i / n
+		points.append(Vector2(cos(a), sin(a)) * radius)
+	return points
+
+func zigzag(n, length, amplitude):
+	# a worst case for splitting: every split only takes off one point, so
+	# this one is quadratic.
+	var points = PoolVector2Array()
+	for i in range(n - 2):
+		var y = amplitude * (1 - 2 * (i % 2)) * (1.0 + float(i) / n)
+		points.append(Vector2(length * i / n, y))
+	points.append(Vector2(length, 1000))
+	points.append(Vector2(0, 1000))
+	return points
+
+func run(name, points, quality):
+	var tesselator = Tesselator2D.new()
+	tesselator.quality = quality
+
+	var best = -1
+	var kept = 0
+	for i in range(RUNS):
+		var t0 = OS.get_ticks_usec()
+		kept = tesselator.simplify_outline(points).size()
+		var t = OS.get_ticks_usec() - t0
+		if best < 0 or t < best:
+			best = t
+
+	print("%-12s %8d points -> %8d kept, %10.2f ms (quality %d)" % [
+		name, points.size(), kept, best / 1000.0, quality])
+
+	tesselator.free()
+
+func _init():
+	for quality in [100, 25]:
+		run("circle", circle(POINTS, 2000), quality)
+		run("zigzag", zigzag(POINTS, 2000, 0.01), quality)
+	quit()
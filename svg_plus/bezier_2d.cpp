@@ -3,6 +3,7 @@
 /*************************************************************************/
 
 #include "bezier_2d.h"
+#include "core/hashfuncs.h"
 #include "core/math/geometry.h"
 #include "core/sort.h"
 #include "scene/2d/polygon_2d.h"
@@ -48,16 +49,41 @@ static void flatten_cubic_bezier(
 	flatten_cubic_bezier(x1234, y1234, x234, y234, x34, y34, x4, y4, p_level + 1, p_parameters, r_path);
 }
 
-static void flatten_path(const Vector<Vector2> &p_path, const Tesselator2D::TesselationParameters &p_parameters, ClipperLib::Path &r_path) {
+static inline int get_segment_count(int p_points) {
+
+	return p_points > 0 ? (p_points - 1) / 3 : 0;
+}
+
+void Bezier2D::_flatten_path(Path &p_path, const ClipperLib::IntPoint &p_origin, const Tesselator2D::TesselationParameters &p_parameters, ClipperLib::Path &r_path) {
+
+	// every cubic segment is flattened on its own and cached in absolute
+	// coordinates. editing a point thus only flattens its adjacent segments.
+
+	const Vector<Vector2> &points = p_path.points;
+	if (points.empty()) {
+		return;
+	}
+
+	const int n = get_segment_count(points.size());
+	if (p_path.segments.size() != n) {
+		p_path.segments.clear();
+		p_path.segments.resize(n);
+	}
 
 	const float s = 1.0 * p_parameters.scale;
-	const ClipperLib::IntPoint p0 = ClipperLib::IntPoint(p_path[0].x * s, p_path[0].y * s);
+	const ClipperLib::IntPoint p0 = ClipperLib::IntPoint(points[0].x * s - p_origin.X, points[0].y * s - p_origin.Y);
 
 	r_path.push_back(p0);
-	const int n = p_path.size();
-	for (int i = 0; i + 3 < n; i += 3) {
-		const Vector2 *p = &p_path[i];
-		flatten_cubic_bezier(p[0].x * s, p[0].y * s, p[1].x * s, p[1].y * s, p[2].x * s, p[2].y * s, p[3].x * s, p[3].y * s, 1, p_parameters, r_path);
+	for (int i = 0; i < n; i++) {
+		ClipperLib::Path &segment = p_path.segments[i];
+		if (segment.empty()) {
+			const Vector2 *p = &points[3 * i];
+			flatten_cubic_bezier(p[0].x * s, p[0].y * s, p[1].x * s, p[1].y * s, p[2].x * s, p[2].y * s, p[3].x * s, p[3].y * s, 1, p_parameters, segment);
+		}
+
+		for (int j = 0; j < segment.size(); j++) {
+			r_path.push_back(ClipperLib::IntPoint(segment[j].X - p_origin.X, segment[j].Y - p_origin.Y));
+		}
 	}
 	r_path.push_back(p0);
 }
@@ -79,12 +105,79 @@ Tesselator2D *Bezier2D::_get_tesselator() const {
 
 void Bezier2D::_mark_dirty() {
 
+	morph_data.tolerance = 0;
+	_invalidate_mesh_caches();
+
+	if (!is_inside_tree()) {
+		return; // not registered yet
+	}
+
 	Tesselator2D *tesselator = _get_tesselator();
 	if (tesselator) {
 		tesselator->mark_dirty(tesselator->get_path_to(this));
 	}
 }
 
+void Bezier2D::_get_instance_key(Vector2 &r_origin, Vector<real_t> &r_key) const {
+
+	// describes the shape's geometry up to translation by r_origin.
+
+	r_origin = Vector2();
+	for (int i = 0; i < paths.size(); i++) {
+		if (paths[i].points.size() > 0) {
+			r_origin = paths[i].points[0];
+			break;
+		}
+	}
+
+	r_key.clear();
+	r_key.push_back(fill_rule);
+	r_key.push_back(stroke_width);
+	r_key.push_back(culled ? 1 : 0);
+	r_key.push_back(hairline ? 1 : 0);
+	r_key.push_back(antialiased ? 1 : 0);
+
+	// linear gradients cut the geometry along their stops, relative to r_origin.
+	for (int k = 0; k < 2; k++) {
+		Transform2D gradient_xform;
+		Vector<float> stops;
+		if (!_get_gradient_stops(k == 1, gradient_xform, stops)) {
+			r_key.push_back(0);
+			continue;
+		}
+		gradient_xform = gradient_xform * Transform2D(0, r_origin);
+		r_key.push_back(stops.size());
+		for (int i = 0; i < 3; i++) {
+			r_key.push_back(gradient_xform.elements[i].x);
+			r_key.push_back(gradient_xform.elements[i].y);
+		}
+		for (int i = 0; i < stops.size(); i++) {
+			r_key.push_back(stops[i]);
+		}
+	}
+	for (int i = 0; i < paths.size(); i++) {
+		const Vector<Vector2> &points = paths[i].points;
+		r_key.push_back(points.size());
+		r_key.push_back(paths[i].closed ? 1 : 0);
+		for (int j = 0; j < points.size(); j++) {
+			r_key.push_back(points[j].x - r_origin.x);
+			r_key.push_back(points[j].y - r_origin.y);
+		}
+	}
+}
+
+void Bezier2D::_mark_paint_dirty() {
+
+	if (!is_inside_tree()) {
+		return;
+	}
+
+	Tesselator2D *tesselator = _get_tesselator();
+	if (tesselator) {
+		tesselator->mark_paint_dirty();
+	}
+}
+
 void Bezier2D::_tesselate_lock(const Tesselator2D::TesselationParameters &p_parameters, ClipperLib::Path &r_points) {
 
 	r_points.clear();
@@ -101,12 +194,29 @@ void Bezier2D::_tesselate_lock(const Tesselator2D::TesselationParameters &p_para
 
 void Bezier2D::_tesselate_fill(
 		const Tesselator2D::TesselationParameters &p_parameters,
-		ClipperLib::Paths &r_paths) {
+		ClipperLib::Paths &r_paths,
+		const Vector2 &p_origin) {
+
+	if (flattened_scale != p_parameters.scale ||
+			flattened_tolerance != p_parameters.tolerance ||
+			flattened_max_levels != p_parameters.max_levels) {
+
+		for (int i = 0; i < paths.size(); i++) {
+			paths[i].segments.clear();
+		}
+		flattened_scale = p_parameters.scale;
+		flattened_tolerance = p_parameters.tolerance;
+		flattened_max_levels = p_parameters.max_levels;
+	}
+
+	const ClipperLib::IntPoint origin(
+			Math::round(p_origin.x * p_parameters.scale),
+			Math::round(p_origin.y * p_parameters.scale));
 
 	ClipperLib::Paths clipper_paths;
 	for (int i = 0; i < paths.size(); i++) {
 		ClipperLib::Path clipper_path;
-		flatten_path(paths[i].points, p_parameters, clipper_path);
+		_flatten_path(paths[i], origin, p_parameters, clipper_path);
 		clipper_paths.push_back(clipper_path);
 	}
 
@@ -159,6 +269,63 @@ void Bezier2D::_tesselate_stroke(
 	}
 }
 
+bool Bezier2D::_get_gradient_stops(bool p_stroke, Transform2D &r_transform, Vector<float> &r_stops) const {
+
+	const Paint &paint = p_stroke ? stroke_paint : fill_paint;
+	if (paint.gradient.is_null() || paint.type != GRADIENT_LINEAR) {
+		return false;
+	}
+
+	r_transform = paint.transform;
+	r_stops = paint.gradient->get_offsets();
+	return r_stops.size() > 0;
+}
+
+bool Bezier2D::is_hairline() const {
+
+	return hairline;
+}
+
+bool Bezier2D::is_opaque() const {
+
+	return is_visible() && get_modulate().a >= 1.0 && get_self_modulate().a >= 1.0;
+}
+
+bool Bezier2D::is_culled() const {
+
+	return culled;
+}
+
+bool Bezier2D::is_morphing() const {
+
+	return !morph_data.target.empty();
+}
+
+Rect2 Bezier2D::get_control_bounds() const {
+
+	// curves lie within the hull of their control points, so this contains
+	// the shape without flattening it. in path space, stroke included.
+
+	Rect2 r;
+	bool empty = true;
+	for (int i = 0; i < paths.size(); i++) {
+		const Vector<Vector2> &points = paths[i].points;
+		for (int j = 0; j < points.size(); j++) {
+			if (empty) {
+				r = Rect2(points[j], Vector2());
+				empty = false;
+			} else {
+				r.expand_to(points[j]);
+			}
+		}
+	}
+
+	if (!empty && stroke_width > 0) {
+		r = r.grow(0.5 * stroke_width);
+	}
+	return r;
+}
+
 Dictionary Bezier2D::_edit_get_state() const {
 	Dictionary state = Node2D::_edit_get_state();
 	state["offset"] = offset;
@@ -191,7 +358,7 @@ Rect2 Bezier2D::_edit_get_rect() const {
 	Tesselator2D::Tesselation tesselation;
 	tesselator->get_tesselation(tesselator->get_path_to(this), tesselation);
 
-	return Rect2(tesselation.bounds.position + offset, tesselation.bounds.size);
+	return Rect2(tesselation.bounds.position + tesselation.origin + offset, tesselation.bounds.size);
 }
 
 bool Bezier2D::_edit_is_selected_on_click(const Point2 &p_point, double p_tolerance) const {
@@ -202,7 +369,7 @@ bool Bezier2D::_edit_is_selected_on_click(const Point2 &p_point, double p_tolera
 	Tesselator2D::Tesselation tesselation;
 	tesselator->get_tesselation(tesselator->get_path_to(this), tesselation);
 
-	Point2 p = p_point - offset;
+	Point2 p = p_point - offset - tesselation.origin;
 
 	for (int i = 0; i < tesselation.fill.size(); i++) {
 		if (Geometry::is_point_in_polygon(p, tesselation.fill[i])) {
@@ -226,12 +393,32 @@ int Bezier2D::get_path_count() const {
 
 Vector<Vector2> Bezier2D::get_path_points(int p_path) const {
 
+	ERR_FAIL_INDEX_V(p_path, paths.size(), Vector<Vector2>());
 	return paths[p_path].points;
 }
 
 void Bezier2D::set_path_points(int p_path, const Vector<Vector2> &p_points) {
 
-	paths[p_path].points = p_points;
+	ERR_FAIL_INDEX(p_path, paths.size());
+
+	Path &path = paths[p_path];
+	const Vector<Vector2> &old_points = path.points;
+
+	if (old_points.size() != p_points.size()) {
+		path.segments.clear();
+	} else {
+		const int n = MIN(get_segment_count(p_points.size()), path.segments.size());
+		for (int i = 0; i < n; i++) {
+			for (int j = 3 * i; j <= 3 * i + 3; j++) {
+				if (old_points[j] != p_points[j]) {
+					path.segments[i].clear();
+					break;
+				}
+			}
+		}
+	}
+
+	path.points = p_points;
 	_mark_dirty();
 	update();
 }
@@ -247,9 +434,93 @@ void Bezier2D::add_path(const Vector<Vector2> &p_points) {
 	update();
 }
 
+void Bezier2D::clear_paths() {
+
+	paths.clear();
+
+	_mark_dirty();
+	update();
+}
+
+void Bezier2D::_set_data(const Dictionary &p_data) {
+
+	// all paths are stored in one point array to keep the encoding compact.
+
+	ERR_FAIL_COND(!p_data.has("points"));
+	ERR_FAIL_COND(!p_data.has("counts"));
+	ERR_FAIL_COND(!p_data.has("closed"));
+
+	PoolVector2Array points = p_data["points"];
+	PoolIntArray counts = p_data["counts"];
+	PoolByteArray closed = p_data["closed"];
+	ERR_FAIL_COND(counts.size() != closed.size());
+
+	paths.clear();
+
+	PoolVector2Array::Read r_points = points.read();
+	PoolIntArray::Read r_counts = counts.read();
+	PoolByteArray::Read r_closed = closed.read();
+
+	int k = 0;
+	for (int i = 0; i < counts.size(); i++) {
+		const int n = r_counts[i];
+		ERR_BREAK(n < 0 || k + n > points.size());
+
+		Path path;
+		path.points.resize(n);
+		for (int j = 0; j < n; j++) {
+			path.points[j] = r_points[k++];
+		}
+		path.closed = r_closed[i] != 0;
+		paths.push_back(path);
+	}
+
+	_mark_dirty();
+	update();
+}
+
+Dictionary Bezier2D::_get_data() const {
+
+	int total = 0;
+	for (int i = 0; i < paths.size(); i++) {
+		total += paths[i].points.size();
+	}
+
+	PoolVector2Array points;
+	PoolIntArray counts;
+	PoolByteArray closed;
+	points.resize(total);
+	counts.resize(paths.size());
+	closed.resize(paths.size());
+
+	{
+		PoolVector2Array::Write w_points = points.write();
+		PoolIntArray::Write w_counts = counts.write();
+		PoolByteArray::Write w_closed = closed.write();
+
+		int k = 0;
+		for (int i = 0; i < paths.size(); i++) {
+			const Vector<Vector2> &path_points = paths[i].points;
+			for (int j = 0; j < path_points.size(); j++) {
+				w_points[k++] = path_points[j];
+			}
+			w_counts[i] = path_points.size();
+			w_closed[i] = paths[i].closed ? 1 : 0;
+		}
+	}
+
+	Dictionary data;
+	data["points"] = points;
+	data["counts"] = counts;
+	data["closed"] = closed;
+	return data;
+}
+
 void Bezier2D::set_fill_color(const Color &p_color) {
 
 	fill_color = p_color;
+	_invalidate_mesh_caches();
+	_mark_paint_dirty();
 	update();
 }
 
@@ -261,6 +532,8 @@ Color Bezier2D::get_fill_color() const {
 void Bezier2D::set_stroke_color(const Color &p_color) {
 
 	stroke_color = p_color;
+	_invalidate_mesh_caches();
+	_mark_paint_dirty();
 	update();
 }
 
@@ -269,6 +542,107 @@ Color Bezier2D::get_stroke_color() const {
 	return stroke_color;
 }
 
+void Bezier2D::_set_gradient(Paint &p_paint, const Ref<Gradient> &p_gradient) {
+
+	if (p_paint.gradient == p_gradient) {
+		return;
+	}
+
+	if (p_paint.gradient.is_valid()) {
+		p_paint.gradient->disconnect("changed", this, "_gradient_changed");
+	}
+	p_paint.gradient = p_gradient;
+	if (p_paint.gradient.is_valid()) {
+		p_paint.gradient->connect("changed", this, "_gradient_changed");
+	}
+
+	p_paint.ramp.unref();
+	_mark_dirty();
+	update();
+}
+
+void Bezier2D::_gradient_changed() {
+
+	fill_paint.ramp.unref();
+	stroke_paint.ramp.unref();
+	_mark_dirty(); // stops might have moved
+	update();
+}
+
+void Bezier2D::set_fill_gradient(const Ref<Gradient> &p_gradient) {
+
+	_set_gradient(fill_paint, p_gradient);
+}
+
+Ref<Gradient> Bezier2D::get_fill_gradient() const {
+
+	return fill_paint.gradient;
+}
+
+void Bezier2D::set_fill_gradient_type(GradientType p_type) {
+
+	if (fill_paint.type != p_type) {
+		fill_paint.type = p_type;
+		fill_paint.ramp.unref();
+		_mark_dirty();
+		update();
+	}
+}
+
+Bezier2D::GradientType Bezier2D::get_fill_gradient_type() const {
+
+	return fill_paint.type;
+}
+
+void Bezier2D::set_fill_gradient_transform(const Transform2D &p_transform) {
+
+	fill_paint.transform = p_transform;
+	_mark_dirty();
+	update();
+}
+
+Transform2D Bezier2D::get_fill_gradient_transform() const {
+
+	return fill_paint.transform;
+}
+
+void Bezier2D::set_stroke_gradient(const Ref<Gradient> &p_gradient) {
+
+	_set_gradient(stroke_paint, p_gradient);
+}
+
+Ref<Gradient> Bezier2D::get_stroke_gradient() const {
+
+	return stroke_paint.gradient;
+}
+
+void Bezier2D::set_stroke_gradient_type(GradientType p_type) {
+
+	if (stroke_paint.type != p_type) {
+		stroke_paint.type = p_type;
+		stroke_paint.ramp.unref();
+		_mark_dirty();
+		update();
+	}
+}
+
+Bezier2D::GradientType Bezier2D::get_stroke_gradient_type() const {
+
+	return stroke_paint.type;
+}
+
+void Bezier2D::set_stroke_gradient_transform(const Transform2D &p_transform) {
+
+	stroke_paint.transform = p_transform;
+	_mark_dirty();
+	update();
+}
+
+Transform2D Bezier2D::get_stroke_gradient_transform() const {
+
+	return stroke_paint.transform;
+}
+
 void Bezier2D::set_stroke_width(float p_width) {
 
 	stroke_width = p_width;
@@ -281,7 +655,7 @@ float Bezier2D::get_stroke_width() const {
 	return stroke_width;
 }
 
-void Bezier2D::set_fill_rule(const FillRule &p_fill_rule) {
+void Bezier2D::set_fill_rule(FillRule p_fill_rule) {
 
 	if (fill_rule != p_fill_rule) {
 		fill_rule = p_fill_rule;
@@ -297,8 +671,11 @@ Bezier2D::FillRule Bezier2D::get_fill_rule() const {
 
 void Bezier2D::set_antialiased(bool p_antialiased) {
 
-	antialiased = p_antialiased;
-	update();
+	if (antialiased != p_antialiased) {
+		antialiased = p_antialiased;
+		_mark_dirty();
+		update();
+	}
 }
 
 bool Bezier2D::get_antialiased() const {
@@ -309,6 +686,7 @@ bool Bezier2D::get_antialiased() const {
 void Bezier2D::set_offset(const Vector2 &p_offset) {
 
 	offset = p_offset;
+	_mark_paint_dirty();
 	update();
 	_change_notify("offset");
 }
@@ -318,46 +696,583 @@ Vector2 Bezier2D::get_offset() const {
 	return offset;
 }
 
-void Bezier2D::_draw_polygons(const Tesselator2D::Polygons &p_polygons, const Color &p_color) const {
+static Ref<ImageTexture> make_radial_ramp(Ref<Gradient> p_gradient) {
+
+	// a 2d ramp, so that uvs can be interpolated linearly across triangles.
+	// clamping at the texture's border pads with the last stop's color.
+	const int size = 128;
+
+	PoolVector<uint8_t> data;
+	data.resize(size * size * 4);
+	{
+		PoolVector<uint8_t>::Write w = data.write();
+		uint8_t *p = w.ptr();
+		for (int y = 0; y < size; y++) {
+			for (int x = 0; x < size; x++) {
+				const Vector2 d((x + 0.5) * 2.0 / size - 1.0, (y + 0.5) * 2.0 / size - 1.0);
+				const Color c = p_gradient->get_color_at_offset(d.length());
+				*p++ = CLAMP(c.r * 255.0, 0, 255);
+				*p++ = CLAMP(c.g * 255.0, 0, 255);
+				*p++ = CLAMP(c.b * 255.0, 0, 255);
+				*p++ = CLAMP(c.a * 255.0, 0, 255);
+			}
+		}
+	}
+
+	Ref<Image> image = memnew(Image(size, size, false, Image::FORMAT_RGBA8, data));
+	Ref<ImageTexture> texture;
+	texture.instance();
+	texture->create_from_image(image, Texture::FLAG_FILTER);
+	return texture;
+}
+
+Vector<Bezier2D::RadialRamp> Bezier2D::radial_ramps;
+
+Ref<ImageTexture> Bezier2D::_get_radial_ramp(const Ref<Gradient> &p_gradient) {
+
+	// the canvas has no per pixel radial lookup without a shader, so the ramp
+	// is baked into a 2d texture. it is the same for every shape using the
+	// same stops, and is shared between them. only drawing builds ramps, so
+	// this is not locked.
+
+	const Vector<float> offsets = p_gradient->get_offsets();
+	const Vector<Color> colors = p_gradient->get_colors();
+
+	uint32_t hash = 5381;
+	for (int i = 0; i < offsets.size(); i++) {
+		hash = hash_djb2_one_float(offsets[i], hash);
+	}
+	for (int i = 0; i < colors.size(); i++) {
+		hash = hash_djb2_one_float(colors[i].r, hash);
+		hash = hash_djb2_one_float(colors[i].g, hash);
+		hash = hash_djb2_one_float(colors[i].b, hash);
+		hash = hash_djb2_one_float(colors[i].a, hash);
+	}
+
+	for (int i = 0; i < radial_ramps.size(); i++) {
+		const RadialRamp &ramp = radial_ramps[i];
+		if (ramp.hash != hash || ramp.offsets.size() != offsets.size() || ramp.colors.size() != colors.size()) {
+			continue;
+		}
+
+		bool same = true;
+		for (int j = 0; j < offsets.size() && same; j++) {
+			same = ramp.offsets[j] == offsets[j];
+		}
+		for (int j = 0; j < colors.size() && same; j++) {
+			same = ramp.colors[j] == colors[j];
+		}
+		if (same) {
+			return ramp.texture;
+		}
+	}
+
+	// drop ramps no shape uses anymore.
+	for (int i = radial_ramps.size() - 1; i >= 0; i--) {
+		if (radial_ramps[i].texture->reference_get_count() <= 1) {
+			radial_ramps.remove(i);
+		}
+	}
+
+	RadialRamp ramp;
+	ramp.hash = hash;
+	ramp.offsets = offsets;
+	ramp.colors = colors;
+	ramp.texture = make_radial_ramp(p_gradient);
+	radial_ramps.push_back(ramp);
+	return ramp.texture;
+}
+
+void Bezier2D::finalize_radial_ramps() {
 
-	if (p_polygons.size() < 1) {
+	radial_ramps.clear();
+}
+
+void Bezier2D::_draw_mesh(const Tesselator2D::Mesh &p_mesh, uint32_t p_version, const Vector2 &p_origin, float p_fringe, const Color &p_color, Paint &p_paint, MeshCache &r_cache) {
+
+	if (p_mesh.indices.empty()) {
 		return;
 	}
 
-	Vector<Vector2> points;
-	Vector<Vector2> uvs;
+	const int n = p_mesh.vertices.size();
+	const bool fringe = !p_mesh.coverage.empty();
+
+	// colors and uvs only change with the tesselation or the paint, which
+	// clears the cache. a version of 0 is never cached.
+	if (p_version == 0 || r_cache.version != p_version || r_cache.origin != p_origin) {
+		r_cache.version = p_version;
+		r_cache.origin = p_origin;
+		r_cache.vertices.clear();
+		r_cache.colors.clear();
+		r_cache.uvs.clear();
+
+		if (p_paint.gradient.is_null()) {
+			// a single color is used for all vertices, no per vertex arrays needed,
+			// except for fringes which fade out towards their outer edge.
+			if (!fringe) {
+				r_cache.colors.push_back(p_color);
+			} else {
+				r_cache.colors.resize(n);
+				for (int i = 0; i < n; i++) {
+					r_cache.colors[i] = Color(p_color.r, p_color.g, p_color.b, p_color.a * p_mesh.coverage[i]);
+				}
+			}
+		} else if (p_paint.type == GRADIENT_LINEAR) {
+			// the tesselator cut the mesh at the stops, so colors are exact per vertex.
+			r_cache.colors.resize(n);
+			for (int i = 0; i < n; i++) {
+				const real_t t = p_paint.transform.xform(p_mesh.vertices[i] + p_origin).y;
+				Color c = p_paint.gradient->get_color_at_offset(t);
+				if (fringe) {
+					c.a *= p_mesh.coverage[i];
+				}
+				r_cache.colors[i] = c;
+			}
+		} else {
+			r_cache.uvs.resize(n);
+			for (int i = 0; i < n; i++) {
+				r_cache.uvs[i] = Vector2(0.5, 0.5) + 0.5 * p_paint.transform.xform(p_mesh.vertices[i] + p_origin);
+			}
 
-	Vector<int> indices;
-	for (int i = 0; i < p_polygons.size(); i++) {
+			if (!fringe) {
+				r_cache.colors.push_back(Color(1, 1, 1));
+			} else {
+				r_cache.colors.resize(n);
+				for (int i = 0; i < n; i++) {
+					r_cache.colors[i] = Color(1, 1, 1, p_mesh.coverage[i]);
+				}
+			}
+		}
+	}
 
-		const int n = p_polygons[i].size();
-		const int p0 = points.size();
-		points.resize(p0 + n);
+	// fringes are a number of screen pixels wide, so their outer vertices move
+	// with the zoom. colors and uvs stay with the inner edge's.
+	if (fringe && (r_cache.vertices.empty() || r_cache.width != p_fringe)) {
+		r_cache.width = p_fringe;
+		r_cache.vertices.resize(n);
+		for (int i = 0; i < n; i++) {
+			r_cache.vertices[i] = p_mesh.vertices[i];
+		}
+		if (p_mesh.normals.size() == n) { // stored by older versions without
+			for (int i = 0; i < n; i++) {
+				r_cache.vertices[i] += p_mesh.normals[i] * p_fringe;
+			}
+		}
+	}
 
-		for (int j = 0; j < n; j++) {
-			points[p0 + j] = p_polygons[i][j] + offset;
+	RID texture;
+	if (p_paint.gradient.is_valid() && p_paint.type == GRADIENT_RADIAL) {
+		if (p_paint.ramp.is_null()) {
+			p_paint.ramp = _get_radial_ramp(p_paint.gradient);
 		}
+		texture = p_paint.ramp->get_rid();
+	}
 
-		Vector<int> sub_indices = Geometry::triangulate_polygon(p_polygons[i]);
+	const Vector<Vector2> &vertices = fringe ? r_cache.vertices : p_mesh.vertices;
+	VS::get_singleton()->canvas_item_add_triangle_array(get_canvas_item(), p_mesh.indices, vertices, r_cache.colors, r_cache.uvs, texture);
+}
 
-		const int from = indices.size();
-		indices.resize(from + sub_indices.size());
-		for (int j = 0; j < sub_indices.size(); j++) {
-			indices[from + j] = sub_indices[j] + p0;
+void Bezier2D::_invalidate_mesh_caches() {
+
+	fill_cache.version = 0;
+	fill_fringe_cache.version = 0;
+	stroke_cache.version = 0;
+	stroke_fringe_cache.version = 0;
+}
+
+Array Bezier2D::get_collision_polygons(float p_tolerance, bool p_convex) const {
+
+	// in this node's space, for use with CollisionPolygon2D or occluders.
+	// cached by the tesselator until the shape's geometry changes.
+
+	Tesselator2D *tesselator = _get_tesselator();
+	ERR_FAIL_COND_V(!tesselator, Array());
+	ERR_FAIL_COND_V(p_tolerance <= 0, Array());
+
+	const Tesselator2D::Polygons polygons = tesselator->get_collision_polygons(tesselator->get_path_to(this), p_tolerance, p_convex);
+
+	Array result;
+	for (int i = 0; i < polygons.size(); i++) {
+		Vector<Vector2> polygon = polygons[i];
+		for (int j = 0; j < polygon.size(); j++) {
+			polygon[j] += offset;
 		}
+		result.push_back(polygon);
 	}
+	return result;
+}
 
-	if (indices.empty()) {
-		return;
+void Bezier2D::set_morph_target(const Array &p_paths) {
+
+	// the target needs the same paths with the same number of points, so
+	// that segments correspond.
+
+	Vector<Vector<Vector2> > target;
+	for (int i = 0; i < p_paths.size(); i++) {
+		const Vector<Vector2> points = p_paths[i];
+		target.push_back(points);
 	}
 
+	if (!target.empty()) {
+		ERR_FAIL_COND(target.size() != paths.size());
+		for (int i = 0; i < target.size(); i++) {
+			ERR_FAIL_COND(target[i].size() != paths[i].points.size());
+		}
+	}
+
+	// setting or clearing the target takes the shape out of the meld and
+	// occlusion, or puts it back.
+	const bool was_morphing = is_morphing();
+	morph_data.target = target;
+	morph_data.tolerance = 0;
+	if (is_morphing() != was_morphing) {
+		_mark_dirty();
+	}
+	update();
+}
+
+Array Bezier2D::get_morph_target() const {
+
+	Array target;
+	for (int i = 0; i < morph_data.target.size(); i++) {
+		target.push_back(morph_data.target[i]);
+	}
+	return target;
+}
+
+void Bezier2D::set_morph(float p_morph) {
+
+	morph = p_morph;
+	update();
+}
+
+float Bezier2D::get_morph() const {
+
+	return morph;
+}
+
+void Bezier2D::_draw_hairline(const Tesselator2D::Polygons &p_outline, float p_width) const {
+
+	// strokes thinner than a pixel become one pixel lines that fade
+	// with their actual width.
+	Color color = get_stroke_color();
+	color.a *= CLAMP(p_width, 0.0, 1.0);
+
 	Vector<Color> colors;
-	colors.resize(points.size());
-	for (int i = 0; i < points.size(); i++) {
-		colors[i] = p_color;
+	colors.push_back(color);
+
+	for (int i = 0; i < p_outline.size(); i++) {
+		VS::get_singleton()->canvas_item_add_polyline(get_canvas_item(), p_outline[i], colors, 1.0, antialiased);
+	}
+}
+
+bool Bezier2D::_get_hairline(const Tesselator2D *p_tesselator) const {
+
+	if (stroke_width <= 0) {
+		return false;
+	}
+	return stroke_width * _get_canvas_scale() < p_tesselator->get_hairline_width();
+}
+
+void Bezier2D::_update_hairline(Tesselator2D *p_tesselator) {
+
+	// hairlines skip the stroke's tesselation. only this shape's record
+	// changes, the others keep their meld.
+	const bool new_hairline = _get_hairline(p_tesselator);
+	if (new_hairline != hairline) {
+		hairline = new_hairline;
+		p_tesselator->invalidate_record(p_tesselator->get_path_to(this));
+	}
+}
+
+static Color average_paint(const Color &p_color, const Ref<Gradient> &p_gradient) {
+
+	if (p_gradient.is_null()) {
+		return p_color;
+	}
+
+	const Vector<Color> colors = p_gradient->get_colors();
+	if (colors.empty()) {
+		return p_color;
+	}
+
+	Color sum(0, 0, 0, 0);
+	for (int i = 0; i < colors.size(); i++) {
+		sum.r += colors[i].r;
+		sum.g += colors[i].g;
+		sum.b += colors[i].b;
+		sum.a += colors[i].a;
+	}
+	return sum / colors.size();
+}
+
+void Bezier2D::_draw_culled() const {
+
+	// the whole shape fits into about one pixel. a pixel sized quad in the
+	// shape's average color, faded by how much of the pixel the shape can
+	// cover, stands in for it.
+
+	const Rect2 bounds = get_control_bounds();
+	const float scale = _get_canvas_scale();
+	const float coverage = MIN(bounds.size.x * bounds.size.y * scale * scale, 1.0);
+	if (coverage <= 0) {
+		return;
 	}
 
-	VS::get_singleton()->canvas_item_add_triangle_array(get_canvas_item(), indices, points, colors, uvs, RID());
+	const Color fill = average_paint(fill_color, fill_paint.gradient);
+	Color color = fill;
+	if (stroke_width > 0) {
+		// weighted by alpha, so that an invisible fill does not tint the stroke.
+		const Color stroke = average_paint(stroke_color, stroke_paint.gradient);
+		const float a = fill.a + stroke.a;
+		if (a > 0) {
+			color.r = (fill.r * fill.a + stroke.r * stroke.a) / a;
+			color.g = (fill.g * fill.a + stroke.g * stroke.a) / a;
+			color.b = (fill.b * fill.a + stroke.b * stroke.a) / a;
+			color.a = 0.5 * a;
+		}
+	}
+	color.a *= coverage;
+
+	const Vector2 size = Vector2(1, 1) / scale;
+	const Vector2 center = offset + bounds.position + bounds.size * 0.5;
+	VS::get_singleton()->canvas_item_add_rect(get_canvas_item(), Rect2(center - size * 0.5, size), color);
+}
+
+bool Bezier2D::_get_culled(const Tesselator2D *p_tesselator) const {
+
+	const Vector2 size = get_control_bounds().size * _get_canvas_scale();
+	return MAX(size.x, size.y) < p_tesselator->get_cull_size();
+}
+
+void Bezier2D::_update_culled(Tesselator2D *p_tesselator) {
+
+	// only this shape's record changes, the others keep their meld.
+	const bool new_culled = _get_culled(p_tesselator);
+	if (new_culled != culled) {
+		culled = new_culled;
+		p_tesselator->invalidate_record(p_tesselator->get_path_to(this));
+	}
+}
+
+void Bezier2D::_canvas_scale_changed(const Tesselator2D *p_tesselator) {
+
+	// zooming does not redraw by itself. fringes are sized in screen pixels,
+	// and the hairline and culled modes depend on the scale, so shapes that
+	// have one or cross into another redraw here.
+	if (antialiased || _get_hairline(p_tesselator) != hairline || _get_culled(p_tesselator) != culled) {
+		update();
+	}
+}
+
+static int get_cubic_steps(const Vector2 *p_p, real_t p_tolerance) {
+
+	// wang's formula, the number of uniform steps that keeps a cubic
+	// within tolerance of its polyline.
+	const real_t d = MAX((p_p[0] - p_p[1] * 2 + p_p[2]).length(), (p_p[1] - p_p[2] * 2 + p_p[3]).length());
+	return CLAMP(int(Math::ceil(Math::sqrt(0.75 * d / p_tolerance))), 1, 64);
+}
+
+static void flatten_cubic_uniform(const Vector2 *p_p, int p_steps, Vector<Vector2> &r_points) {
+
+	for (int i = 1; i <= p_steps; i++) {
+		const real_t t = real_t(i) / p_steps;
+		const real_t u = 1 - t;
+		r_points.push_back(p_p[0] * (u * u * u) + p_p[1] * (3 * u * u * t) + p_p[2] * (3 * u * t * t) + p_p[3] * (t * t * t));
+	}
+}
+
+static float get_morph_tolerance(const Tesselator2D *p_tesselator) {
+
+	return 25.0 / MAX(p_tesselator->get_quality(), 1.0); // in path space, 0.25 at full quality
+}
+
+void Bezier2D::_update_morph(Tesselator2D *p_tesselator) {
+
+	// both ends are flattened with the same steps per segment, so that their
+	// points match one to one. triangulation happens once, here, and drawing
+	// only interpolates the vertices.
+
+	Morph &m = morph_data;
+	m.tolerance = get_morph_tolerance(p_tesselator);
+	m.from.clear();
+	m.to.clear();
+	m.starts.clear();
+	m.indices.clear();
+
+	ERR_FAIL_COND(m.target.size() != paths.size());
+
+	Tesselator2D::Polygons polygons;
+	for (int i = 0; i < paths.size(); i++) {
+		const Vector<Vector2> &a = paths[i].points;
+		const Vector<Vector2> &b = m.target[i];
+		if (a.size() != b.size()) {
+			m.from.clear();
+			m.to.clear();
+			m.starts.clear();
+			ERR_FAIL();
+		}
+
+		const int start = m.from.size();
+		m.starts.push_back(start);
+		if (a.empty()) {
+			continue;
+		}
+
+		m.from.push_back(a[0]);
+		m.to.push_back(b[0]);
+		for (int j = 0; j < get_segment_count(a.size()); j++) {
+			const int steps = MAX(get_cubic_steps(&a[3 * j], m.tolerance), get_cubic_steps(&b[3 * j], m.tolerance));
+			flatten_cubic_uniform(&a[3 * j], steps, m.from);
+			flatten_cubic_uniform(&b[3 * j], steps, m.to);
+		}
+
+		Vector<Vector2> polygon;
+		for (int j = start; j < m.from.size(); j++) {
+			polygon.push_back(m.from[j]);
+		}
+		polygons.push_back(polygon);
+	}
+	m.starts.push_back(m.from.size());
+
+	m.indices = p_tesselator->triangulate_matched(polygons, fill_rule == FILLRULE_EVENODD);
+}
+
+static void add_strip(const Vector<Vector2> &p_points, int p_begin, int p_end, real_t p_side, real_t p_from, real_t p_to, real_t p_coverage_from, real_t p_coverage_to, Tesselator2D::Mesh &r_mesh) {
+
+	// a band around a closed outline, between two offsets along its mitered
+	// normals. the normals point outwards for outlines of positive area, and
+	// p_side flips them for the others.
+
+	const int n = p_end - p_begin;
+	if (n < 3) {
+		return;
+	}
+
+	const int v0 = r_mesh.vertices.size();
+	for (int i = 0; i < n; i++) {
+		const Vector2 &a = p_points[p_begin + (i + n - 1) % n];
+		const Vector2 &b = p_points[p_begin + i];
+		const Vector2 &c = p_points[p_begin + (i + 1) % n];
+
+		const Vector2 n0 = Vector2(b.y - a.y, a.x - b.x).normalized() * p_side;
+		const Vector2 n1 = Vector2(c.y - b.y, b.x - c.x).normalized() * p_side;
+		Vector2 m = n0 + n1;
+		const real_t length = m.length();
+		m = length > CMP_EPSILON ? m / length : n0;
+		m /= MAX(m.dot(n0), 0.5);
+
+		r_mesh.vertices.push_back(b + m * p_from);
+		r_mesh.vertices.push_back(b + m * p_to);
+		r_mesh.coverage.push_back(p_coverage_from);
+		r_mesh.coverage.push_back(p_coverage_to);
+	}
+
+	for (int i = 0; i < n; i++) {
+		const int a = v0 + 2 * i;
+		const int b = v0 + 2 * ((i + 1) % n);
+		r_mesh.indices.push_back(a);
+		r_mesh.indices.push_back(a + 1);
+		r_mesh.indices.push_back(b);
+		r_mesh.indices.push_back(b);
+		r_mesh.indices.push_back(a + 1);
+		r_mesh.indices.push_back(b + 1);
+	}
+}
+
+static real_t get_area(const Vector<Vector2> &p_points, int p_begin, int p_end) {
+
+	real_t area = 0;
+	for (int i = p_begin; i < p_end; i++) {
+		const Vector2 &a = p_points[i];
+		const Vector2 &b = p_points[i + 1 < p_end ? i + 1 : p_begin];
+		area += a.x * b.y - b.x * a.y;
+	}
+	return area;
+}
+
+void Bezier2D::_draw_morph(const Tesselator2D *p_tesselator) {
+
+	// everything is rebuilt from the interpolated points, with the topology
+	// from _update_morph(). strokes and fringes are bands around the closed
+	// outlines, as fills are closed before stroking in _tesselate_stroke().
+	// there is no meld, and linear gradients are interpolated per vertex
+	// rather than cut at their stops. this is the same at every morph value,
+	// 0 and 1 included, so nothing changes abruptly while morphing.
+
+	const Morph &m = morph_data;
+	const int n = m.from.size();
+
+	Vector<Vector2> points;
+	points.resize(n);
+	for (int i = 0; i < n; i++) {
+		points[i] = m.from[i].linear_interpolate(m.to[i], morph);
+	}
+
+	const RID ci = get_canvas_item();
+	if (offset != Vector2()) {
+		VS::get_singleton()->canvas_item_add_set_transform(ci, Transform2D(0, offset));
+	}
+
+	const float scale = _get_canvas_scale();
+	const float fringe = antialiased && scale > 0 ? p_tesselator->get_fringe_width() / scale : 0;
+	MeshCache cache; // the vertices change on every draw
+
+	Tesselator2D::Mesh fill;
+	fill.vertices = points;
+	fill.indices = m.indices;
+	_draw_mesh(fill, 0, Vector2(), 0, fill_color, fill_paint, cache);
+
+	if (fringe > 0) {
+		Tesselator2D::Mesh fill_fringe;
+		for (int i = 0; i + 1 < m.starts.size(); i++) {
+			const real_t side = get_area(points, m.starts[i], m.starts[i + 1]) < 0 ? -1 : 1;
+			add_strip(points, m.starts[i], m.starts[i + 1], side, 0, fringe, 1, 0, fill_fringe);
+		}
+		_draw_mesh(fill_fringe, 0, Vector2(), 0, fill_color, fill_paint, cache);
+	}
+
+	if (stroke_width > 0 && hairline) {
+		Tesselator2D::Polygons outline;
+		for (int i = 0; i + 1 < m.starts.size(); i++) {
+			if (m.starts[i + 1] - m.starts[i] < 2) {
+				continue;
+			}
+			Vector<Vector2> polyline;
+			for (int j = m.starts[i]; j < m.starts[i + 1]; j++) {
+				polyline.push_back(points[j]);
+			}
+			polyline.push_back(polyline[0]);
+			outline.push_back(polyline);
+		}
+		_draw_hairline(outline, stroke_width * scale);
+	} else if (stroke_width > 0) {
+		const real_t w = 0.5 * stroke_width;
+
+		Tesselator2D::Mesh stroke;
+		Tesselator2D::Mesh stroke_fringe;
+		for (int i = 0; i + 1 < m.starts.size(); i++) {
+			add_strip(points, m.starts[i], m.starts[i + 1], 1, -w, w, 1, 1, stroke);
+			if (fringe > 0) {
+				add_strip(points, m.starts[i], m.starts[i + 1], 1, w, w + fringe, 1, 0, stroke_fringe);
+				add_strip(points, m.starts[i], m.starts[i + 1], 1, -w, -w - fringe, 1, 0, stroke_fringe);
+			}
+		}
+		stroke.coverage.clear(); // solid
+
+		_draw_mesh(stroke, 0, Vector2(), 0, stroke_color, stroke_paint, cache);
+		_draw_mesh(stroke_fringe, 0, Vector2(), 0, stroke_color, stroke_paint, cache);
+	}
+
+	if (offset != Vector2()) {
+		VS::get_singleton()->canvas_item_add_set_transform(ci, Transform2D());
+	}
+}
+
+float Bezier2D::_get_canvas_scale() const {
+
+	const Transform2D xform = get_global_transform_with_canvas();
+	return Math::sqrt(Math::abs(xform.basis_determinant()));
 }
 
 void Bezier2D::_notification(int p_what) {
@@ -369,11 +1284,60 @@ void Bezier2D::_notification(int p_what) {
 			Tesselator2D *tesselator = _get_tesselator();
 			ERR_FAIL_COND(!tesselator);
 
+			// changing the modulate redraws, but does not notify otherwise.
+			if (is_opaque() != opaque) {
+				opaque = !opaque;
+				_mark_paint_dirty();
+			}
+
+			_update_hairline(tesselator);
+
+			// with a morph target, the precomputed topology replaces the
+			// tesselation at every morph value, so that there is no jump
+			// between the two.
+			if (!morph_data.target.empty()) {
+				if (morph_data.tolerance != get_morph_tolerance(tesselator)) {
+					_update_morph(tesselator);
+				}
+				if (morph_data.starts.size() == paths.size() + 1) {
+					_draw_morph(tesselator);
+					break;
+				}
+			}
+
+			_update_culled(tesselator);
+
 			Tesselator2D::Tesselation tesselation;
 			tesselator->get_tesselation(tesselator->get_path_to(this), tesselation);
 
-			_draw_polygons(tesselation.fill, get_fill_color());
-			_draw_polygons(tesselation.stroke, get_stroke_color());
+			if (culled) {
+				_draw_culled();
+				break;
+			}
+
+			// meshes are cached in local space, so move them with a transform.
+			const Vector2 translation = offset + tesselation.origin;
+			const RID ci = get_canvas_item();
+			if (translation != Vector2()) {
+				VS::get_singleton()->canvas_item_add_set_transform(ci, Transform2D(0, translation));
+			}
+
+			const uint32_t version = tesselation.version;
+			const Vector2 origin = tesselation.origin;
+			const float scale = _get_canvas_scale();
+			const float fringe = scale > 0 ? tesselator->get_fringe_width() / scale : 0;
+			_draw_mesh(tesselation.fill_mesh, version, origin, 0, fill_color, fill_paint, fill_cache);
+			_draw_mesh(tesselation.fill_fringe, version, origin, fringe, fill_color, fill_paint, fill_fringe_cache);
+			if (hairline) {
+				_draw_hairline(tesselation.outline, stroke_width * scale);
+			} else {
+				_draw_mesh(tesselation.stroke_mesh, version, origin, 0, stroke_color, stroke_paint, stroke_cache);
+				_draw_mesh(tesselation.stroke_fringe, version, origin, fringe, stroke_color, stroke_paint, stroke_fringe_cache);
+			}
+
+			if (translation != Vector2()) {
+				VS::get_singleton()->canvas_item_add_set_transform(ci, Transform2D());
+			}
 
 		} break;
 
@@ -385,17 +1349,73 @@ void Bezier2D::_notification(int p_what) {
 			}
 
 		} break;
+
+		case NOTIFICATION_LOCAL_TRANSFORM_CHANGED:
+		case NOTIFICATION_VISIBILITY_CHANGED: {
+
+			_mark_paint_dirty();
+
+		} break;
+
+		case NOTIFICATION_EXIT_TREE: {
+
+			Tesselator2D *tesselator = _get_tesselator();
+			if (tesselator) {
+				tesselator->deregister_shape(tesselator->get_path_to(this));
+			}
+
+		} break;
 	}
 }
 
 void Bezier2D::_bind_methods() {
 
+	ClassDB::bind_method(D_METHOD("get_path_count"), &Bezier2D::get_path_count);
+	ClassDB::bind_method(D_METHOD("get_path_points", "path"), &Bezier2D::get_path_points);
+	ClassDB::bind_method(D_METHOD("set_path_points", "path", "points"), &Bezier2D::set_path_points);
+	ClassDB::bind_method(D_METHOD("add_path", "points"), &Bezier2D::add_path);
+	ClassDB::bind_method(D_METHOD("clear_paths"), &Bezier2D::clear_paths);
+
+	ClassDB::bind_method(D_METHOD("get_collision_polygons", "tolerance", "convex"), &Bezier2D::get_collision_polygons, DEFVAL(1.0), DEFVAL(false));
+
+	ClassDB::bind_method(D_METHOD("set_morph_target", "paths"), &Bezier2D::set_morph_target);
+	ClassDB::bind_method(D_METHOD("get_morph_target"), &Bezier2D::get_morph_target);
+
+	ClassDB::bind_method(D_METHOD("set_morph", "morph"), &Bezier2D::set_morph);
+	ClassDB::bind_method(D_METHOD("get_morph"), &Bezier2D::get_morph);
+
+	ClassDB::bind_method(D_METHOD("_set_data", "data"), &Bezier2D::_set_data);
+	ClassDB::bind_method(D_METHOD("_get_data"), &Bezier2D::_get_data);
+
+	ClassDB::bind_method(D_METHOD("set_fill_rule", "fill_rule"), &Bezier2D::set_fill_rule);
+	ClassDB::bind_method(D_METHOD("get_fill_rule"), &Bezier2D::get_fill_rule);
+
 	ClassDB::bind_method(D_METHOD("set_fill_color", "color"), &Bezier2D::set_fill_color);
 	ClassDB::bind_method(D_METHOD("get_fill_color"), &Bezier2D::get_fill_color);
 
 	ClassDB::bind_method(D_METHOD("set_stroke_color", "color"), &Bezier2D::set_stroke_color);
 	ClassDB::bind_method(D_METHOD("get_stroke_color"), &Bezier2D::get_stroke_color);
 
+	ClassDB::bind_method(D_METHOD("set_fill_gradient", "gradient"), &Bezier2D::set_fill_gradient);
+	ClassDB::bind_method(D_METHOD("get_fill_gradient"), &Bezier2D::get_fill_gradient);
+
+	ClassDB::bind_method(D_METHOD("set_fill_gradient_type", "type"), &Bezier2D::set_fill_gradient_type);
+	ClassDB::bind_method(D_METHOD("get_fill_gradient_type"), &Bezier2D::get_fill_gradient_type);
+
+	ClassDB::bind_method(D_METHOD("set_fill_gradient_transform", "transform"), &Bezier2D::set_fill_gradient_transform);
+	ClassDB::bind_method(D_METHOD("get_fill_gradient_transform"), &Bezier2D::get_fill_gradient_transform);
+
+	ClassDB::bind_method(D_METHOD("set_stroke_gradient", "gradient"), &Bezier2D::set_stroke_gradient);
+	ClassDB::bind_method(D_METHOD("get_stroke_gradient"), &Bezier2D::get_stroke_gradient);
+
+	ClassDB::bind_method(D_METHOD("set_stroke_gradient_type", "type"), &Bezier2D::set_stroke_gradient_type);
+	ClassDB::bind_method(D_METHOD("get_stroke_gradient_type"), &Bezier2D::get_stroke_gradient_type);
+
+	ClassDB::bind_method(D_METHOD("set_stroke_gradient_transform", "transform"), &Bezier2D::set_stroke_gradient_transform);
+	ClassDB::bind_method(D_METHOD("get_stroke_gradient_transform"), &Bezier2D::get_stroke_gradient_transform);
+
+	ClassDB::bind_method(D_METHOD("_gradient_changed"), &Bezier2D::_gradient_changed);
+
 	ClassDB::bind_method(D_METHOD("set_stroke_width", "width"), &Bezier2D::set_stroke_width);
 	ClassDB::bind_method(D_METHOD("get_stroke_width"), &Bezier2D::get_stroke_width);
 
@@ -405,11 +1425,28 @@ void Bezier2D::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("set_offset", "offset"), &Bezier2D::set_offset);
 	ClassDB::bind_method(D_METHOD("get_offset"), &Bezier2D::get_offset);
 
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "fill_rule", PROPERTY_HINT_ENUM, "NonZero,EvenOdd"), "set_fill_rule", "get_fill_rule");
 	ADD_PROPERTY(PropertyInfo(Variant::COLOR, "fill_color"), "set_fill_color", "get_fill_color");
+	ADD_PROPERTY(PropertyInfo(Variant::OBJECT, "fill_gradient", PROPERTY_HINT_RESOURCE_TYPE, "Gradient"), "set_fill_gradient", "get_fill_gradient");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "fill_gradient_type", PROPERTY_HINT_ENUM, "Linear,Radial"), "set_fill_gradient_type", "get_fill_gradient_type");
+	ADD_PROPERTY(PropertyInfo(Variant::TRANSFORM2D, "fill_gradient_transform"), "set_fill_gradient_transform", "get_fill_gradient_transform");
 	ADD_PROPERTY(PropertyInfo(Variant::COLOR, "stroke_color"), "set_stroke_color", "get_stroke_color");
+	ADD_PROPERTY(PropertyInfo(Variant::OBJECT, "stroke_gradient", PROPERTY_HINT_RESOURCE_TYPE, "Gradient"), "set_stroke_gradient", "get_stroke_gradient");
+	ADD_PROPERTY(PropertyInfo(Variant::INT, "stroke_gradient_type", PROPERTY_HINT_ENUM, "Linear,Radial"), "set_stroke_gradient_type", "get_stroke_gradient_type");
+	ADD_PROPERTY(PropertyInfo(Variant::TRANSFORM2D, "stroke_gradient_transform"), "set_stroke_gradient_transform", "get_stroke_gradient_transform");
 	ADD_PROPERTY(PropertyInfo(Variant::REAL, "stroke_width"), "set_stroke_width", "get_stroke_width");
 	ADD_PROPERTY(PropertyInfo(Variant::VECTOR2, "offset"), "set_offset", "get_offset");
 	ADD_PROPERTY(PropertyInfo(Variant::BOOL, "antialiased"), "set_antialiased", "get_antialiased");
+	ADD_PROPERTY(PropertyInfo(Variant::DICTIONARY, "_data", PROPERTY_HINT_NONE, "", PROPERTY_USAGE_NOEDITOR | PROPERTY_USAGE_INTERNAL), "_set_data", "_get_data");
+	// after _data, the target is checked against the paths.
+	ADD_PROPERTY(PropertyInfo(Variant::REAL, "morph", PROPERTY_HINT_RANGE, "0,1,0.001"), "set_morph", "get_morph");
+	ADD_PROPERTY(PropertyInfo(Variant::ARRAY, "morph_target", PROPERTY_HINT_NONE, "", PROPERTY_USAGE_NOEDITOR), "set_morph_target", "get_morph_target");
+
+	BIND_ENUM_CONSTANT(FILLRULE_NONZERO);
+	BIND_ENUM_CONSTANT(FILLRULE_EVENODD);
+
+	BIND_ENUM_CONSTANT(GRADIENT_LINEAR);
+	BIND_ENUM_CONSTANT(GRADIENT_RADIAL);
 }
 
 Bezier2D::Bezier2D() {
@@ -418,6 +1455,19 @@ Bezier2D::Bezier2D() {
 	fill_color = Color(1, 1, 1);
 	stroke_color = Color(0, 0, 0);
 	stroke_width = 3.0;
+	fill_paint.type = GRADIENT_LINEAR;
+	stroke_paint.type = GRADIENT_LINEAR;
 	offset = Vector2(0, 0);
 	antialiased = false;
+	hairline = false;
+	culled = false;
+	opaque = true;
+	morph = 0;
+	morph_data.tolerance = 0;
+
+	flattened_scale = 0;
+	flattened_tolerance = 0;
+	flattened_max_levels = 0;
+
+	set_notify_local_transform(true);
 }
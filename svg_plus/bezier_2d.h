@@ -6,6 +6,8 @@
 #define BEZIER_2D_H
 
 #include "scene/2d/node_2d.h"
+#include "scene/resources/gradient.h"
+#include "scene/resources/texture.h"
 #include "tesselator_2d.h"
 #include "thirdparty/misc/clipper.hpp"
 #include "thirdparty/misc/triangulator.h"
@@ -20,43 +22,141 @@ public:
 		FILLRULE_EVENODD
 	};
 
+	enum GradientType {
+		GRADIENT_LINEAR,
+		GRADIENT_RADIAL
+	};
+
 private:
 	struct Path {
 		Vector<Vector2> points;
 		bool closed;
+		Vector<ClipperLib::Path> segments; // flattened cubics, empty if not cached
 	};
 
 	Vector<Path> paths;
 
+	struct Paint {
+		Ref<Gradient> gradient; // overrides the color if set
+		GradientType type;
+		Transform2D transform; // path space to gradient space
+		Ref<ImageTexture> ramp; // radial gradients only, shared, see _get_radial_ramp()
+	};
+
+	// radial ramps of all shapes, so that shapes with the same gradient
+	// share one texture.
+	struct RadialRamp {
+		uint32_t hash;
+		Vector<float> offsets;
+		Vector<Color> colors;
+		Ref<ImageTexture> texture;
+	};
+
+	static Vector<RadialRamp> radial_ramps;
+	static Ref<ImageTexture> _get_radial_ramp(const Ref<Gradient> &p_gradient);
+
+	float flattened_scale;
+	float flattened_tolerance;
+	int flattened_max_levels;
+
 	FillRule fill_rule;
 	Color fill_color;
+	Paint fill_paint;
 
 	Color stroke_color;
+	Paint stroke_paint;
 	float stroke_width;
 
 	bool antialiased;
 	Vector2 offset;
 
+	bool hairline; // stroke is drawn as thin lines, see _update_hairline()
+	bool culled; // drawn as a single pixel, see _update_culled()
+	bool opaque; // as last drawn, for occlusion culling
+
+	struct Morph {
+		Vector<Vector<Vector2> > target; // control points, matching paths
+		float tolerance; // the flattening below was built with, 0 if not built
+		Vector<Vector2> from; // flattened paths, point i of from matches point i of to
+		Vector<Vector2> to;
+		Vector<int> starts; // flattened path i is [starts[i], starts[i + 1])
+		Vector<int> indices; // fill triangles, valid at both ends
+	};
+
+	Morph morph_data;
+	float morph;
+
+	// per vertex arrays for drawing a tesselation mesh, kept between draws.
+	struct MeshCache {
+		uint32_t version; // of the tesselation they were built from, 0 if invalid
+		Vector2 origin;
+		float width; // of the fringe, in local units
+		Vector<Vector2> vertices; // fringes only, others draw the mesh's own
+		Vector<Color> colors;
+		Vector<Vector2> uvs;
+
+		MeshCache() {
+			version = 0;
+			width = 0;
+		}
+	};
+
+	MeshCache fill_cache;
+	MeshCache fill_fringe_cache;
+	MeshCache stroke_cache;
+	MeshCache stroke_fringe_cache;
+
 	Tesselator2D *_get_tesselator() const;
+	void _flatten_path(Path &p_path, const ClipperLib::IntPoint &p_origin, const Tesselator2D::TesselationParameters &p_parameters, ClipperLib::Path &r_path);
 	void _mark_dirty();
-
-	void _draw_polygons(const Tesselator2D::Polygons &p_polygons, const Color &p_color) const;
+	void _mark_paint_dirty();
+
+	void _draw_mesh(const Tesselator2D::Mesh &p_mesh, uint32_t p_version, const Vector2 &p_origin, float p_fringe, const Color &p_color, Paint &p_paint, MeshCache &r_cache);
+	void _invalidate_mesh_caches();
+	void _draw_hairline(const Tesselator2D::Polygons &p_outline, float p_width) const;
+	bool _get_hairline(const Tesselator2D *p_tesselator) const;
+	void _update_hairline(Tesselator2D *p_tesselator);
+	void _draw_culled() const;
+	bool _get_culled(const Tesselator2D *p_tesselator) const;
+	void _update_culled(Tesselator2D *p_tesselator);
+	void _update_morph(Tesselator2D *p_tesselator);
+	void _draw_morph(const Tesselator2D *p_tesselator);
+	float _get_canvas_scale() const;
+
+	void _set_gradient(Paint &p_paint, const Ref<Gradient> &p_gradient);
+	void _gradient_changed();
+
+	void _set_data(const Dictionary &p_data);
+	Dictionary _get_data() const;
 
 protected:
 	void _notification(int p_what);
 	static void _bind_methods();
 
 public:
+	void _get_instance_key(Vector2 &r_origin, Vector<real_t> &r_key) const;
 	void _tesselate_lock(
 			const Tesselator2D::TesselationParameters &p_parameters,
 			ClipperLib::Path &r_points);
 	void _tesselate_fill(
 			const Tesselator2D::TesselationParameters &p_parameters,
-			ClipperLib::Paths &r_paths);
+			ClipperLib::Paths &r_paths,
+			const Vector2 &p_origin = Vector2());
 	void _tesselate_stroke(
 			const Tesselator2D::TesselationParameters &p_parameters,
 			const ClipperLib::Paths &p_fill,
 			ClipperLib::Paths &r_paths);
+	bool _get_gradient_stops(bool p_stroke, Transform2D &r_transform, Vector<float> &r_stops) const;
+
+	static void finalize_radial_ramps();
+
+	void _canvas_scale_changed(const Tesselator2D *p_tesselator);
+
+	bool is_hairline() const;
+	bool is_opaque() const;
+	bool is_culled() const;
+	bool is_morphing() const;
+	Rect2 get_control_bounds() const;
 
 	virtual Dictionary _edit_get_state() const;
 	virtual void _edit_set_state(const Dictionary &p_state);
@@ -72,8 +172,9 @@ public:
 	Vector<Vector2> get_path_points(int p_path) const;
 	void set_path_points(int p_path, const Vector<Vector2> &p_points);
 	void add_path(const Vector<Vector2> &p_points);
+	void clear_paths();
 
-	void set_fill_rule(const FillRule &p_fill_rule);
+	void set_fill_rule(FillRule p_fill_rule);
 	FillRule get_fill_rule() const;
 
 	void set_fill_color(const Color &p_color);
@@ -82,6 +183,24 @@ public:
 	void set_stroke_color(const Color &p_color);
 	Color get_stroke_color() const;
 
+	void set_fill_gradient(const Ref<Gradient> &p_gradient);
+	Ref<Gradient> get_fill_gradient() const;
+
+	void set_fill_gradient_type(GradientType p_type);
+	GradientType get_fill_gradient_type() const;
+
+	void set_fill_gradient_transform(const Transform2D &p_transform);
+	Transform2D get_fill_gradient_transform() const;
+
+	void set_stroke_gradient(const Ref<Gradient> &p_gradient);
+	Ref<Gradient> get_stroke_gradient() const;
+
+	void set_stroke_gradient_type(GradientType p_type);
+	GradientType get_stroke_gradient_type() const;
+
+	void set_stroke_gradient_transform(const Transform2D &p_transform);
+	Transform2D get_stroke_gradient_transform() const;
+
 	void set_stroke_width(float p_width);
 	float get_stroke_width() const;
 
@@ -91,7 +210,18 @@ public:
 	void set_offset(const Vector2 &p_offset);
 	Vector2 get_offset() const;
 
+	Array get_collision_polygons(float p_tolerance, bool p_convex) const;
+
+	void set_morph_target(const Array &p_paths);
+	Array get_morph_target() const;
+
+	void set_morph(float p_morph);
+	float get_morph() const;
+
 	Bezier2D();
 };
 
+VARIANT_ENUM_CAST(Bezier2D::FillRule);
+VARIANT_ENUM_CAST(Bezier2D::GradientType);
+
 #endif // BEZIER_2D_H
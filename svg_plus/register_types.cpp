@@ -6,16 +6,23 @@
 #include "bezier_2d.h"
 #include "bezier_2d_editor_plugin.h"
 #include "svg.h"
+#include "svg_atlas.h"
+#include "svg_batch.h"
 
 static ResourceFormatLoaderSVG *svg_loader = NULL;
 
 void register_svg_plus_types() {
 
+	SVGRasterizerPool::initialize();
+	TesselationWorkerPool::initialize();
+
 	svg_loader = memnew(ResourceFormatLoaderSVG);
 	ResourceLoader::add_resource_format_loader(svg_loader);
 
 	ClassDB::register_class<SVG>();
 	ClassDB::register_class<SVGInstance>();
+	ClassDB::register_class<SVGAtlas>();
+	ClassDB::register_class<SVGBatchConverter>();
 	ClassDB::register_class<Bezier2D>();
 
 	/*#ifdef TOOLS_ENABLED
@@ -25,4 +32,8 @@ void register_svg_plus_types() {
 }
 
 void unregister_svg_plus_types() {
+
+	SVGRasterizerPool::finalize();
+	TesselationWorkerPool::finalize();
+	Bezier2D::finalize_radial_ramps();
 }
@@ -5,34 +5,403 @@
 #include "svg.h"
 #include "../svg/image_loader_svg.h"
 #include "bezier_2d.cpp"
+#include "core/map.h"
+#include "core/os/copymem.h"
+#include "core/os/os.h"
+#include "core/set.h"
 #include "os/file_access.h"
 #include "scene/2d/polygon_2d.h"
 
-NSVGimage *NanoSVG::get_data() const {
+Mutex *SVGRasterizerPool::mutex = NULL;
+Vector<SVGRasterizer *> SVGRasterizerPool::rasterizers;
+int SVGRasterizerPool::max_idle = 0;
+bool SVGRasterizerPool::initialized = false;
 
-	return data;
+SVGRasterizer *SVGRasterizerPool::acquire() {
+
+	// outside of initialize() and finalize() there is no pool, every
+	// call gets a rasterizer of its own.
+	if (!initialized) {
+		return memnew(SVGRasterizer);
+	}
+
+	// without threads there is no mutex, and nothing to race with.
+	if (mutex) {
+		mutex->lock();
+	}
+
+	SVGRasterizer *rasterizer = NULL;
+	if (!rasterizers.empty()) {
+		rasterizer = rasterizers[rasterizers.size() - 1];
+		rasterizers.resize(rasterizers.size() - 1);
+	}
+
+	if (mutex) {
+		mutex->unlock();
+	}
+
+	if (!rasterizer) {
+		rasterizer = memnew(SVGRasterizer);
+	}
+	return rasterizer;
+}
+
+void SVGRasterizerPool::release(SVGRasterizer *p_rasterizer) {
+
+	bool kept = false;
+	if (initialized) {
+		if (mutex) {
+			mutex->lock();
+		}
+
+		// a burst of threads leaves at most one idle rasterizer per core.
+		if (rasterizers.size() < max_idle) {
+			rasterizers.push_back(p_rasterizer);
+			kept = true;
+		}
+
+		if (mutex) {
+			mutex->unlock();
+		}
+	}
+
+	if (!kept) {
+		memdelete(p_rasterizer);
+	}
 }
 
-NanoSVG::NanoSVG(const String &p_path, const String &p_units, float p_dpi) {
+void SVGRasterizerPool::initialize() {
 
-	data = NULL;
+	mutex = Mutex::create();
+	max_idle = MAX(1, OS::get_singleton()->get_processor_count());
+	initialized = true;
+}
+
+void SVGRasterizerPool::finalize() {
+
+	initialized = false;
+
+	for (int i = 0; i < rasterizers.size(); i++) {
+		memdelete(rasterizers[i]);
+	}
+	rasterizers.clear();
+
+	if (mutex) {
+		memdelete(mutex);
+		mutex = NULL;
+	}
+}
+
+/////////////////////////
+
+Error SVGData::parse(const String &p_path, const String &p_units, float p_dpi) {
 
 	Vector<uint8_t> buf = FileAccess::get_file_as_array(p_path);
 
 	String str;
 	str.parse_utf8((const char *)buf.ptr(), buf.size());
 
-	data = nsvgParse((char *)str.utf8().get_data(), p_units.utf8().get_data(), p_dpi);
+	NSVGimage *image = nsvgParse((char *)str.utf8().get_data(), p_units.utf8().get_data(), p_dpi);
+	if (!image) {
+		return ERR_FILE_CORRUPT;
+	}
+
+	// convert nanosvg's linked lists into flat arrays once, then free them.
+
+	width = image->width;
+	height = image->height;
+
+	int n_shapes = 0;
+	int n_paths = 0;
+	int n_points = 0;
+	for (NSVGshape *shape = image->shapes; shape; shape = shape->next) {
+		for (NSVGpath *path = shape->paths; path; path = path->next) {
+			n_points += path->npts;
+			n_paths++;
+		}
+		n_shapes++;
+	}
+
+	points.resize(2 * n_points);
+	path_starts.resize(n_paths + 1);
+	path_closed.resize(n_paths);
+	path_bounds.resize(4 * n_paths);
+
+	shape_ids.resize(n_shapes);
+	shape_path_starts.resize(n_shapes + 1);
+	shape_fills.resize(n_shapes);
+	shape_strokes.resize(n_shapes);
+	shape_opacities.resize(n_shapes);
+	shape_stroke_widths.resize(n_shapes);
+	shape_fill_rules.resize(n_shapes);
+	shape_bounds.resize(n_shapes);
+	shape_dash_offsets.resize(n_shapes);
+	shape_dash_arrays.resize(8 * n_shapes);
+	shape_dash_counts.resize(n_shapes);
+	shape_line_joins.resize(n_shapes);
+	shape_line_caps.resize(n_shapes);
+	shape_miter_limits.resize(n_shapes);
+	shape_flags.resize(n_shapes);
+
+	gradients.clear();
+
+	int shape_index = 0;
+	int path_index = 0;
+	int point_index = 0;
+
+	for (NSVGshape *shape = image->shapes; shape; shape = shape->next) {
+
+		shape_path_starts[shape_index] = path_index;
+
+		for (NSVGpath *path = shape->paths; path; path = path->next) {
+			path_starts[path_index] = point_index;
+			path_closed[path_index] = path->closed;
+			for (int i = 0; i < 4; i++) {
+				path_bounds[4 * path_index + i] = path->bounds[i];
+			}
+			for (int i = 0; i < 2 * path->npts; i++) {
+				points[2 * point_index + i] = path->pts[i];
+			}
+			point_index += path->npts;
+			path_index++;
+		}
+
+		const NSVGpaint *paints[2] = { &shape->fill, &shape->stroke };
+		Paint converted[2];
+		for (int i = 0; i < 2; i++) {
+			const NSVGpaint *paint = paints[i];
+			converted[i].type = paint->type;
+			converted[i].color = 0;
+			converted[i].gradient = -1;
+
+			if (paint->type == NSVG_PAINT_LINEAR_GRADIENT || paint->type == NSVG_PAINT_RADIAL_GRADIENT) {
+				const NSVGgradient *gradient = paint->gradient;
+				const int size = sizeof(NSVGgradient) + sizeof(NSVGgradientStop) * MAX(gradient->nstops - 1, 0);
+				Vector<uint8_t> data;
+				data.resize(size);
+				copymem(&data[0], gradient, size);
+				converted[i].gradient = gradients.size();
+				gradients.push_back(data);
+			} else {
+				converted[i].color = paint->color;
+			}
+		}
+
+		shape_ids[shape_index] = String::utf8(shape->id);
+		shape_fills[shape_index] = converted[0];
+		shape_strokes[shape_index] = converted[1];
+		shape_opacities[shape_index] = shape->opacity;
+		shape_stroke_widths[shape_index] = shape->strokeWidth;
+		shape_fill_rules[shape_index] = shape->fillRule;
+		shape_bounds[shape_index] = Rect2(
+				shape->bounds[0],
+				shape->bounds[1],
+				shape->bounds[2] - shape->bounds[0],
+				shape->bounds[3] - shape->bounds[1]);
+
+		shape_dash_offsets[shape_index] = shape->strokeDashOffset;
+		for (int i = 0; i < 8; i++) {
+			shape_dash_arrays[8 * shape_index + i] = shape->strokeDashArray[i];
+		}
+		shape_dash_counts[shape_index] = shape->strokeDashCount;
+		shape_line_joins[shape_index] = shape->strokeLineJoin;
+		shape_line_caps[shape_index] = shape->strokeLineCap;
+		shape_miter_limits[shape_index] = shape->miterLimit;
+		shape_flags[shape_index] = shape->flags;
+
+		shape_index++;
+	}
+
+	shape_path_starts[n_shapes] = path_index;
+	path_starts[n_paths] = point_index;
+
+	nsvgDelete(image);
+	return OK;
 }
 
-NanoSVG::~NanoSVG() {
+static void make_nsvg_paint(const SVGData::Paint &p_paint, const SVGData *p_data, NSVGpaint &r_paint) {
+
+	r_paint.type = p_paint.type;
+	if (p_paint.gradient >= 0) {
+		r_paint.gradient = const_cast<NSVGgradient *>(p_data->get_gradient(p_paint.gradient));
+	} else {
+		r_paint.color = p_paint.color;
+	}
+}
+
+static bool shape_in_clip(const Rect2 &p_bounds, float p_stroke_width, const Rect2 &p_clip) {
+
+	// nanosvg's bounds do not include the stroke. miters may reach further
+	// than this, which is why the margin is generous.
+	const Rect2 r = p_bounds.grow(2 * p_stroke_width + 1);
+	return r.position.x <= p_clip.position.x + p_clip.size.x && r.position.x + r.size.x >= p_clip.position.x &&
+		   r.position.y <= p_clip.position.y + p_clip.size.y && r.position.y + r.size.y >= p_clip.position.y;
+}
+
+void SVGData::make_view(View &r_view, const Rect2 *p_clip) const {
+
+	// builds a temporary NSVGimage for nanosvg's rasterizer. it points into
+	// our arrays, so it is only valid as long as this object is unchanged.
+	// shapes outside p_clip (in document space) are left out entirely, so
+	// the rasterizer never sets up their edges.
+
+	const int n_shapes = get_shape_count();
+	const int n_paths = get_path_count();
+
+	r_view.shapes.resize(n_shapes);
+	r_view.paths.resize(n_paths);
+
+	r_view.image.width = width;
+	r_view.image.height = height;
+	r_view.image.shapes = NULL;
+
+	NSVGshape *last = NULL;
+	int k = 0;
+
+	for (int i = 0; i < n_shapes; i++) {
+		if (p_clip && !shape_in_clip(shape_bounds[i], shape_stroke_widths[i], *p_clip)) {
+			continue;
+		}
+
+		NSVGshape &shape = r_view.shapes[k++];
+		zeromem(&shape, sizeof(NSVGshape)); // the id is not needed for rasterizing
+
+		make_nsvg_paint(shape_fills[i], this, shape.fill);
+		make_nsvg_paint(shape_strokes[i], this, shape.stroke);
+		shape.opacity = shape_opacities[i];
+		shape.strokeWidth = shape_stroke_widths[i];
+		shape.strokeDashOffset = shape_dash_offsets[i];
+		for (int l = 0; l < 8; l++) {
+			shape.strokeDashArray[l] = shape_dash_arrays[8 * i + l];
+		}
+		shape.strokeDashCount = shape_dash_counts[i];
+		shape.strokeLineJoin = shape_line_joins[i];
+		shape.strokeLineCap = shape_line_caps[i];
+		shape.miterLimit = shape_miter_limits[i];
+		shape.fillRule = shape_fill_rules[i];
+		shape.flags = shape_flags[i];
+		shape.bounds[0] = shape_bounds[i].position.x;
+		shape.bounds[1] = shape_bounds[i].position.y;
+		shape.bounds[2] = shape_bounds[i].position.x + shape_bounds[i].size.x;
+		shape.bounds[3] = shape_bounds[i].position.y + shape_bounds[i].size.y;
+
+		const int path_start = shape_path_starts[i];
+		const int path_end = shape_path_starts[i + 1];
+		for (int j = path_start; j < path_end; j++) {
+			NSVGpath &path = r_view.paths[j];
+			path.pts = const_cast<float *>(get_path_points(j));
+			path.npts = get_path_point_count(j);
+			path.closed = path_closed[j];
+			for (int l = 0; l < 4; l++) {
+				path.bounds[l] = path_bounds[4 * j + l];
+			}
+			path.next = j + 1 < path_end ? &r_view.paths[j + 1] : NULL;
+		}
+		shape.paths = path_end > path_start ? &r_view.paths[path_start] : NULL;
+		shape.next = NULL;
 
-	if (data) {
-		nsvgDelete(data);
-		data = NULL;
+		if (last) {
+			last->next = &shape;
+		} else {
+			r_view.image.shapes = &shape;
+		}
+		last = &shape;
 	}
 }
 
+float SVGData::get_width() const {
+
+	return width;
+}
+
+float SVGData::get_height() const {
+
+	return height;
+}
+
+int SVGData::get_shape_count() const {
+
+	return shape_ids.size();
+}
+
+String SVGData::get_shape_id(int p_shape) const {
+
+	return shape_ids[p_shape];
+}
+
+int SVGData::get_shape_path_start(int p_shape) const {
+
+	return shape_path_starts[p_shape];
+}
+
+int SVGData::get_shape_path_end(int p_shape) const {
+
+	return shape_path_starts[p_shape + 1];
+}
+
+const SVGData::Paint &SVGData::get_shape_fill(int p_shape) const {
+
+	return shape_fills[p_shape];
+}
+
+const SVGData::Paint &SVGData::get_shape_stroke(int p_shape) const {
+
+	return shape_strokes[p_shape];
+}
+
+float SVGData::get_shape_opacity(int p_shape) const {
+
+	return shape_opacities[p_shape];
+}
+
+float SVGData::get_shape_stroke_width(int p_shape) const {
+
+	return shape_stroke_widths[p_shape];
+}
+
+int SVGData::get_shape_fill_rule(int p_shape) const {
+
+	return shape_fill_rules[p_shape];
+}
+
+Rect2 SVGData::get_shape_bounds(int p_shape) const {
+
+	return shape_bounds[p_shape];
+}
+
+int SVGData::get_path_count() const {
+
+	return path_closed.size();
+}
+
+int SVGData::get_path_point_count(int p_path) const {
+
+	return path_starts[p_path + 1] - path_starts[p_path];
+}
+
+const float *SVGData::get_path_points(int p_path) const {
+
+	return points.ptr() + 2 * path_starts[p_path];
+}
+
+bool SVGData::is_path_closed(int p_path) const {
+
+	return path_closed[p_path];
+}
+
+const NSVGgradient *SVGData::get_gradient(int p_gradient) const {
+
+	return (const NSVGgradient *)gradients[p_gradient].ptr();
+}
+
+SVGData::SVGData() {
+
+	width = 0;
+	height = 0;
+	path_starts.push_back(0);
+	shape_path_starts.push_back(0);
+}
+
 /////////////////////////
 
 void SVGPath::_bind_methods() {
@@ -46,20 +415,23 @@ void SVGPath::_bind_methods() {
 
 bool SVGPath::is_closed() const {
 
-	return path->closed;
+	return svg->is_path_closed(path);
 }
 
 Array SVGPath::get_points() const {
 
+	const int n = svg->get_path_point_count(path);
+	const float *pts = svg->get_path_points(path);
+
 	Array points;
-	ERR_FAIL_COND_V(points.resize(path->npts) != OK, Array());
-	for (int i = 0; i < path->npts; i++) {
-		points[i] = Vector2(path->pts[2 * i + 0], path->pts[2 * i + 1]);
+	ERR_FAIL_COND_V(points.resize(n) != OK, Array());
+	for (int i = 0; i < n; i++) {
+		points[i] = Vector2(pts[2 * i + 0], pts[2 * i + 1]);
 	}
 	return points;
 }
 
-SVGPath::SVGPath(const Ref<NanoSVG> &p_svg, const NSVGpath *p_path) {
+SVGPath::SVGPath(const Ref<SVGData> &p_svg, int p_path) {
 
 	svg = p_svg;
 	path = p_path;
@@ -67,32 +439,60 @@ SVGPath::SVGPath(const Ref<NanoSVG> &p_svg, const NSVGpath *p_path) {
 
 /////////////////////////
 
-static Variant convert_nsvg_paint(const NSVGpaint &p_paint) {
+static Color convert_nsvg_color(unsigned int p_color) {
+
+	const float r = (p_color & 0xff) / 255.0;
+	const float g = ((p_color >> 8) & 0xff) / 255.0;
+	const float b = ((p_color >> 16) & 0xff) / 255.0;
+	const float a = ((p_color >> 24) & 0xff) / 255.0;
+	return Color(r, g, b, a);
+}
+
+static Ref<Gradient> convert_nsvg_gradient(const NSVGgradient *p_gradient, Transform2D &r_transform) {
+
+	// nanosvg's xform maps document space to gradient space, where linear
+	// gradients run along y and radial ones have a radius of 1. the focal
+	// point and spread mode are not supported, gradients are always padded.
+
+	const float *t = p_gradient->xform;
+	r_transform = Transform2D(t[0], t[1], t[2], t[3], t[4], t[5]);
+
+	Vector<float> offsets;
+	Vector<Color> colors;
+	for (int i = 0; i < p_gradient->nstops; i++) {
+		offsets.push_back(p_gradient->stops[i].offset);
+		colors.push_back(convert_nsvg_color(p_gradient->stops[i].color));
+	}
+
+	Ref<Gradient> gradient;
+	gradient.instance();
+	gradient->set_offsets(offsets);
+	gradient->set_colors(colors);
+	return gradient;
+}
+
+static Variant convert_nsvg_paint(const SVGData *p_svg, const SVGData::Paint &p_paint) {
 
 	switch (p_paint.type) {
 		case NSVG_PAINT_NONE: {
 			return Variant();
 		} break;
 		case NSVG_PAINT_COLOR: {
-			const float r = (p_paint.color & 0xff) / 255.0;
-			const float g = ((p_paint.color >> 8) & 0xff) / 255.0;
-			const float b = ((p_paint.color >> 16) & 0xff) / 255.0;
-			const float a = ((p_paint.color >> 24) & 0xff) / 255.0;
-			return Color(r, g, b, a);
+			return convert_nsvg_color(p_paint.color);
+		} break;
+		case NSVG_PAINT_LINEAR_GRADIENT:
+		case NSVG_PAINT_RADIAL_GRADIENT: {
+			Transform2D transform;
+			Dictionary gradient;
+			gradient["type"] = p_paint.type == NSVG_PAINT_LINEAR_GRADIENT ? "linear" : "radial";
+			gradient["gradient"] = convert_nsvg_gradient(p_svg->get_gradient(p_paint.gradient), transform);
+			gradient["transform"] = transform;
+			return gradient;
 		} break;
 	}
 	return Variant();
 }
 
-static Rect2 get_shape_bounds(const NSVGshape *p_shape) {
-
-	return Rect2(
-			p_shape->bounds[0],
-			p_shape->bounds[1],
-			p_shape->bounds[2] - p_shape->bounds[0],
-			p_shape->bounds[3] - p_shape->bounds[1]);
-}
-
 void SVGShape::_bind_methods() {
 
 	ClassDB::bind_method(D_METHOD("get_fill"), &SVGShape::get_fill);
@@ -108,31 +508,30 @@ void SVGShape::_bind_methods() {
 
 Variant SVGShape::get_fill() const {
 
-	return convert_nsvg_paint(shape->fill);
+	return convert_nsvg_paint(svg.ptr(), svg->get_shape_fill(shape));
 }
 
 Variant SVGShape::get_stroke() const {
 
-	return convert_nsvg_paint(shape->stroke);
+	return convert_nsvg_paint(svg.ptr(), svg->get_shape_stroke(shape));
 }
 
 float SVGShape::get_opacity() const {
 
-	return shape->opacity;
+	return svg->get_shape_opacity(shape);
 }
 
 Array SVGShape::get_paths() const {
 
 	Array paths;
-	NSVGpath *path = shape->paths;
-	while (path) {
-		paths.push_back(memnew(SVGPath(svg, path)));
-		path = path->next;
+	const int end = svg->get_shape_path_end(shape);
+	for (int i = svg->get_shape_path_start(shape); i < end; i++) {
+		paths.push_back(memnew(SVGPath(svg, i)));
 	}
 	return paths;
 }
 
-SVGShape::SVGShape(const Ref<NanoSVG> &p_svg, const NSVGshape *p_shape) {
+SVGShape::SVGShape(const Ref<SVGData> &p_svg, int p_shape) {
 
 	svg = p_svg;
 	shape = p_shape;
@@ -142,9 +541,11 @@ SVGShape::SVGShape(const Ref<NanoSVG> &p_svg, const NSVGshape *p_shape) {
 
 Error SVG::load(const String &p_path, const String &p_units, float p_dpi) {
 
-	Ref<NanoSVG> new_svg = memnew(NanoSVG(p_path, p_units, p_dpi));
-	if (!new_svg->get_data()) {
-		return ERR_FILE_CORRUPT;
+	Ref<SVGData> new_svg;
+	new_svg.instance();
+	Error err = new_svg->parse(p_path, p_units, p_dpi);
+	if (err != OK) {
+		return err;
 	}
 	svg = new_svg;
 	return OK;
@@ -152,12 +553,12 @@ Error SVG::load(const String &p_path, const String &p_units, float p_dpi) {
 
 float SVG::get_width() const {
 
-	return svg.is_valid() ? svg->get_data()->width : 0;
+	return svg.is_valid() ? svg->get_width() : 0;
 }
 
 float SVG::get_height() const {
 
-	return svg.is_valid() ? svg->get_data()->height : 0;
+	return svg.is_valid() ? svg->get_height() : 0;
 }
 
 Array SVG::get_shapes() const {
@@ -165,28 +566,100 @@ Array SVG::get_shapes() const {
 	ERR_FAIL_COND_V(!svg.is_valid(), Array());
 
 	Array shapes;
-	NSVGshape *shape = svg->get_data()->shapes;
-	while (shape) {
-		shapes.push_back(memnew(SVGShape(svg, shape)));
-		shape = shape->next;
+	for (int i = 0; i < svg->get_shape_count(); i++) {
+		shapes.push_back(memnew(SVGShape(svg, i)));
 	}
 
 	return shapes;
 }
 
+static bool equal_points(const Vector<Vector2> &p_a, const Vector<Vector2> &p_b) {
+
+	if (p_a.size() != p_b.size()) {
+		return false;
+	}
+	for (int i = 0; i < p_a.size(); i++) {
+		if (p_a[i] != p_b[i]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool equal_gradients(const Ref<Gradient> &p_a, const Ref<Gradient> &p_b) {
+
+	if (p_a.is_null() || p_b.is_null()) {
+		return p_a.is_null() == p_b.is_null();
+	}
+
+	const Vector<float> offsets_a = p_a->get_offsets();
+	const Vector<float> offsets_b = p_b->get_offsets();
+	const Vector<Color> colors_a = p_a->get_colors();
+	const Vector<Color> colors_b = p_b->get_colors();
+	if (offsets_a.size() != offsets_b.size() || colors_a.size() != colors_b.size()) {
+		return false;
+	}
+	for (int i = 0; i < offsets_a.size(); i++) {
+		if (offsets_a[i] != offsets_b[i]) {
+			return false;
+		}
+	}
+	for (int i = 0; i < colors_a.size(); i++) {
+		if (colors_a[i] != colors_b[i]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static void update_paint(Bezier2D *p_bezier, const String &p_prefix, const SVGData *p_svg, const SVGData::Paint &p_paint, const Transform2D &p_to_svg) {
+
+	Color color;
+	Ref<Gradient> gradient;
+	Bezier2D::GradientType type = Bezier2D::GRADIENT_LINEAR;
+	Transform2D transform;
+
+	switch (p_paint.type) {
+		case NSVG_PAINT_COLOR: {
+			color = convert_nsvg_color(p_paint.color);
+		} break;
+		case NSVG_PAINT_LINEAR_GRADIENT:
+		case NSVG_PAINT_RADIAL_GRADIENT: {
+			color = Color(1, 1, 1);
+			gradient = convert_nsvg_gradient(p_svg->get_gradient(p_paint.gradient), transform);
+			transform = transform * p_to_svg;
+			if (p_paint.type == NSVG_PAINT_RADIAL_GRADIENT) {
+				type = Bezier2D::GRADIENT_RADIAL;
+			}
+		} break;
+	}
+
+	if (Color(p_bezier->get(p_prefix + "_color")) != color) {
+		p_bezier->set(p_prefix + "_color", color);
+	}
+	if (!equal_gradients(p_bezier->get(p_prefix + "_gradient"), gradient)) {
+		p_bezier->set(p_prefix + "_gradient", gradient);
+	}
+	if (int(p_bezier->get(p_prefix + "_gradient_type")) != type) {
+		p_bezier->set(p_prefix + "_gradient_type", type);
+	}
+	if (Transform2D(p_bezier->get(p_prefix + "_gradient_transform")) != transform) {
+		p_bezier->set(p_prefix + "_gradient_transform", transform);
+	}
+}
+
 void SVG::update_mesh(Node *p_parent) {
 
-	NSVGshape *shape;
+	ERR_FAIL_COND(!svg.is_valid());
+
+	const int n_shapes = svg->get_shape_count();
 
-	shape = svg->get_data()->shapes;
 	Rect2 bounds;
-	if (shape) {
-		bounds = get_shape_bounds(shape);
-		shape = shape->next;
+	if (n_shapes > 0) {
+		bounds = svg->get_shape_bounds(0);
 	}
-	if (shape) {
-		bounds = bounds.merge(get_shape_bounds(shape));
-		shape = shape->next;
+	if (n_shapes > 1) {
+		bounds = bounds.merge(svg->get_shape_bounds(1));
 	}
 
 	const float ox = bounds.position.x + bounds.size.width / 2;
@@ -194,21 +667,56 @@ void SVG::update_mesh(Node *p_parent) {
 	const float original_size = MAX(bounds.size.width, bounds.size.height);
 	const float sx = 100 / original_size;
 	const float sy = 100 / original_size;
+	const Transform2D to_svg(1.0 / sx, 0, 0, 1.0 / sy, ox, oy); // undoes the mapping below
 
 	int untitled_no = 1;
+	int child_index = 0;
+	Set<StringName> shape_names;
+
+	// existing children by name. svg ids are not valid node paths, so they
+	// are matched as the names Node::set_name() turns them into.
+	Map<StringName, Node *> children;
+	for (int i = 0; i < p_parent->get_child_count(); i++) {
+		Node *child = p_parent->get_child(i);
+		children[child->get_name()] = child;
+	}
+
+	for (int shape = 0; shape < n_shapes; shape++) {
+		String shape_name = svg->get_shape_id(shape).replace(":", "").replace("/", "").replace("@", "");
+		if (shape_name == "") {
+			shape_name = "untitled-" + String::num(untitled_no++);
+		}
+
+		Bezier2D *bezier = NULL;
+		Map<StringName, Node *>::Element *E = children.find(shape_name);
+		if (E) {
+			Node *old = E->get();
+			children.erase(E); // shapes with the same id get a node each
+			bezier = Object::cast_to<Bezier2D>(old);
+			if (!bezier) {
+				p_parent->remove_child(old);
+				old->queue_delete();
+			}
+		}
+
+		if (!bezier) {
+			bezier = memnew(Bezier2D);
+			bezier->set_name(shape_name);
+			p_parent->add_child(bezier);
+			bezier->set_owner(p_parent->get_owner());
+		}
 
-	shape = svg->get_data()->shapes;
-	while (shape) {
-		Bezier2D *bezier = memnew(Bezier2D);
+		// only touch what changed, so that unchanged shapes keep their tesselation.
 
-		Color fill_color = convert_nsvg_paint(shape->fill);
-		bezier->set_fill_color(fill_color);
+		update_paint(bezier, "fill", svg.ptr(), svg->get_shape_fill(shape), to_svg);
+		update_paint(bezier, "stroke", svg.ptr(), svg->get_shape_stroke(shape), to_svg);
 
-		Color stroke_color = convert_nsvg_paint(shape->stroke);
-		bezier->set_stroke_color(stroke_color);
-		bezier->set_stroke_width(shape->stroke.type != NSVG_PAINT_NONE ? shape->strokeWidth : 0.0);
+		const float stroke_width = svg->get_shape_stroke(shape).type != NSVG_PAINT_NONE ? svg->get_shape_stroke_width(shape) : 0.0;
+		if (bezier->get_stroke_width() != stroke_width) {
+			bezier->set_stroke_width(stroke_width);
+		}
 
-		switch (shape->fillRule) {
+		switch (svg->get_shape_fill_rule(shape)) {
 			case NSVG_FILLRULE_NONZERO: {
 				bezier->set_fill_rule(Bezier2D::FILLRULE_NONZERO);
 			} break;
@@ -220,44 +728,129 @@ void SVG::update_mesh(Node *p_parent) {
 			} break;
 		}
 
-		NSVGpath *path = shape->paths;
-		while (path) {
+		Vector<Vector<Vector2> > shape_paths;
+		const int path_end = svg->get_shape_path_end(shape);
+		for (int path = svg->get_shape_path_start(shape); path < path_end; path++) {
+			const int n = svg->get_path_point_count(path);
+			const float *pts = svg->get_path_points(path);
+
 			Vector<Vector2> points;
-			points.resize(path->npts);
-			for (int i = 0; i < path->npts; i++) {
+			points.resize(n);
+			for (int i = 0; i < n; i++) {
 				points[i] = Vector2(
-						(path->pts[2 * i + 0] - ox) * sx,
-						(path->pts[2 * i + 1] - oy) * sy);
+						(pts[2 * i + 0] - ox) * sx,
+						(pts[2 * i + 1] - oy) * sy);
 			}
-			bezier->add_path(points);
+			shape_paths.push_back(points);
+		}
 
-			path = path->next;
+		if (bezier->get_path_count() == shape_paths.size()) {
+			for (int i = 0; i < shape_paths.size(); i++) {
+				if (!equal_points(bezier->get_path_points(i), shape_paths[i])) {
+					bezier->set_path_points(i, shape_paths[i]);
+				}
+			}
+		} else {
+			bezier->clear_paths();
+			for (int i = 0; i < shape_paths.size(); i++) {
+				bezier->add_path(shape_paths[i]);
+			}
 		}
 
-		String shape_name = shape->id;
-		if (shape_name == "") {
-			shape_name = "untitled-" + String::num(untitled_no++);
+		if (bezier->get_index() != child_index) {
+			p_parent->move_child(bezier, child_index);
 		}
+		child_index++;
 
-		if (p_parent->has_node(shape_name)) {
-			// FIXME
-			Node *old = p_parent->get_node(shape_name);
+		shape_names.insert(bezier->get_name());
+	}
+
+	for (int i = p_parent->get_child_count() - 1; i >= 0; i--) {
+		Bezier2D *old = Object::cast_to<Bezier2D>(p_parent->get_child(i));
+		if (old && !shape_names.has(old->get_name())) {
 			p_parent->remove_child(old);
 			old->queue_delete();
 		}
-		bezier->set_name(shape_name);
-		p_parent->add_child(bezier);
-		bezier->set_owner(p_parent->get_owner());
+	}
+}
+
+static const int RASTER_BAND_HEIGHT = 256;
+
+static Image::Format get_raster_image_format(SVG::RasterFormat p_format) {
+
+	switch (p_format) {
+		case SVG::RASTER_L8: {
+			return Image::FORMAT_L8;
+		} break;
+		case SVG::RASTER_LA8: {
+			return Image::FORMAT_LA8;
+		} break;
+		case SVG::RASTER_RGBA4444: {
+			return Image::FORMAT_RGBA4444;
+		} break;
+		case SVG::RASTER_RGBA5551: {
+			return Image::FORMAT_RGBA5551;
+		} break;
+		default: {
+			return Image::FORMAT_RGBA8;
+		} break;
+	}
+	return Image::FORMAT_RGBA8;
+}
 
-		shape = shape->next;
+static void convert_raster_pixels(const uint8_t *p_src, uint8_t *p_dst, int p_count, SVG::RasterFormat p_format) {
+
+	// straight loops over bytes, which compilers vectorize well.
+
+	switch (p_format) {
+		case SVG::RASTER_RGBA8: {
+			copymem(p_dst, p_src, p_count * 4);
+		} break;
+		case SVG::RASTER_RGBA8_PREMULTIPLIED: {
+			for (int i = 0; i < p_count; i++) {
+				const unsigned a = p_src[4 * i + 3];
+				p_dst[4 * i + 0] = (p_src[4 * i + 0] * a + 127) / 255;
+				p_dst[4 * i + 1] = (p_src[4 * i + 1] * a + 127) / 255;
+				p_dst[4 * i + 2] = (p_src[4 * i + 2] * a + 127) / 255;
+				p_dst[4 * i + 3] = a;
+			}
+		} break;
+		case SVG::RASTER_L8: {
+			// coverage only, for masks and glyphs.
+			for (int i = 0; i < p_count; i++) {
+				p_dst[i] = p_src[4 * i + 3];
+			}
+		} break;
+		case SVG::RASTER_LA8: {
+			for (int i = 0; i < p_count; i++) {
+				const unsigned l = (54 * p_src[4 * i + 0] + 183 * p_src[4 * i + 1] + 19 * p_src[4 * i + 2]) >> 8;
+				p_dst[2 * i + 0] = l;
+				p_dst[2 * i + 1] = p_src[4 * i + 3];
+			}
+		} break;
+		case SVG::RASTER_RGBA4444: {
+			uint16_t *dst = (uint16_t *)p_dst;
+			for (int i = 0; i < p_count; i++) {
+				const uint8_t *c = p_src + 4 * i;
+				dst[i] = ((c[0] >> 4) << 12) | ((c[1] >> 4) << 8) | ((c[2] >> 4) << 4) | (c[3] >> 4);
+			}
+		} break;
+		case SVG::RASTER_RGBA5551: {
+			uint16_t *dst = (uint16_t *)p_dst;
+			for (int i = 0; i < p_count; i++) {
+				const uint8_t *c = p_src + 4 * i;
+				dst[i] = ((c[0] >> 3) << 11) | ((c[1] >> 3) << 6) | ((c[2] >> 3) << 1) | (c[3] >> 7);
+			}
+		} break;
 	}
 }
 
-Ref<Image> SVG::rasterize(int p_width, int p_height, float p_tx, float p_ty, float p_scale) const {
+Ref<Image> SVG::rasterize(int p_width, int p_height, float p_tx, float p_ty, float p_scale, RasterFormat p_format) const {
 
 	ERR_FAIL_COND_V(!svg.is_valid(), Ref<Image>());
 
-	SVGRasterizer rasterizer;
+	SVGPooledRasterizer pooled;
+	SVGRasterizer &rasterizer = *pooled.rasterizer;
 
 	ERR_FAIL_COND_V(p_width <= 0, Ref<Image>());
 	ERR_FAIL_COND_V(p_height <= 0, Ref<Image>());
@@ -265,21 +858,92 @@ Ref<Image> SVG::rasterize(int p_width, int p_height, float p_tx, float p_ty, flo
 	const int w = p_width;
 	const int h = p_height;
 
+	const Image::Format format = get_raster_image_format(p_format);
+	const int pixel_size = Image::get_format_pixel_size(format);
+
 	PoolVector<uint8_t> dst_image;
-	dst_image.resize(w * h * 4);
+	dst_image.resize(w * h * pixel_size);
 
 	PoolVector<uint8_t>::Write dw = dst_image.write();
 
-	rasterizer.rasterize(svg->get_data(), p_tx, p_ty, p_scale, (unsigned char *)dw.ptr(), w, h, w * 4);
+	if (p_format == RASTER_RGBA8) {
+		rasterize_to(rasterizer, dw.ptr(), w, h, w * 4, p_tx, p_ty, p_scale);
+	} else {
+		// rasterize band by band and convert each band while it is still
+		// in cache, so no full size RGBA8 copy is ever made.
+		const int band_height = MIN(h, RASTER_BAND_HEIGHT);
+		Vector<uint8_t> band;
+		band.resize(w * band_height * 4);
+
+		for (int y = 0; y < h; y += band_height) {
+			const int rows = MIN(band_height, h - y);
+			rasterize_to(rasterizer, &band[0], w, rows, w * 4, p_tx, p_ty - y, p_scale);
+			convert_raster_pixels(&band[0], dw.ptr() + y * w * pixel_size, w * rows, p_format);
+		}
+	}
 
 	dw = PoolVector<uint8_t>::Write();
 	Ref<Image> image;
 	image.instance();
-	image->create(w, h, false, Image::FORMAT_RGBA8, dst_image);
+	image->create(w, h, false, format, dst_image);
 
 	return image;
 }
 
+void SVG::rasterize_to(SVGRasterizer &p_rasterizer, uint8_t *p_dst, int p_width, int p_height, int p_stride, float p_tx, float p_ty, float p_scale) const {
+
+	// writes into a caller owned buffer, e.g. a region of a larger image.
+	// safe to call from several threads, as long as each uses its own rasterizer.
+
+	ERR_FAIL_COND(!svg.is_valid());
+	ERR_FAIL_COND(p_scale <= 0);
+
+	// the destination in document space, to skip shapes that cannot touch it.
+	const Rect2 clip(-p_tx / p_scale, -p_ty / p_scale, p_width / p_scale, p_height / p_scale);
+
+	SVGData::View view;
+	svg->make_view(view, &clip);
+	p_rasterizer.rasterize(&view.image, p_tx, p_ty, p_scale, (unsigned char *)p_dst, p_width, p_height, p_stride);
+}
+
+void SVG::rasterize_region(const Ref<Image> &p_image, const Rect2 &p_region, float p_tx, float p_ty, float p_scale) const {
+
+	// only redraws p_region of p_image, which is assumed to show the whole
+	// document rasterized with p_tx, p_ty and p_scale.
+
+	ERR_FAIL_COND(!svg.is_valid());
+	ERR_FAIL_COND(p_image.is_null());
+	ERR_FAIL_COND(p_image->get_format() != Image::FORMAT_RGBA8);
+	ERR_FAIL_COND(p_image->has_mipmaps());
+
+	const int w = p_image->get_width();
+	const int h = p_image->get_height();
+
+	const int x0 = CLAMP(int(Math::floor(p_region.position.x)), 0, w);
+	const int y0 = CLAMP(int(Math::floor(p_region.position.y)), 0, h);
+	const int x1 = CLAMP(int(Math::ceil(p_region.position.x + p_region.size.x)), 0, w);
+	const int y1 = CLAMP(int(Math::ceil(p_region.position.y + p_region.size.y)), 0, h);
+	if (x1 <= x0 || y1 <= y0) {
+		return;
+	}
+
+	// take the buffer away from the image while drawing, so that writing to
+	// it does not copy the whole image.
+	Ref<Image> image = p_image;
+	PoolVector<uint8_t> data = image->get_data();
+	image->create(1, 1, false, Image::FORMAT_RGBA8);
+
+	{
+		PoolVector<uint8_t>::Write dw = data.write();
+		uint8_t *dst = dw.ptr() + (y0 * w + x0) * 4;
+
+		SVGPooledRasterizer pooled;
+		rasterize_to(*pooled.rasterizer, dst, x1 - x0, y1 - y0, w * 4, p_tx - x0, p_ty - y0, p_scale);
+	}
+
+	image->create(w, h, false, Image::FORMAT_RGBA8, data);
+}
+
 void SVG::_bind_methods() {
 
 	ClassDB::bind_method(D_METHOD("get_width"), &SVG::get_width);
@@ -287,9 +951,20 @@ void SVG::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("get_shapes"), &SVG::get_shapes);
 
 	ClassDB::bind_method(D_METHOD("load", "path", "units", "dpi"), &SVG::load, DEFVAL("px"), DEFVAL(96.0f));
-	ClassDB::bind_method(D_METHOD("rasterize", "tx", "ty", "scale"), &SVG::rasterize, DEFVAL(0.0f), DEFVAL(0.0f), DEFVAL(1.0f));
+	ClassDB::bind_method(D_METHOD("rasterize", "width", "height", "tx", "ty", "scale", "format"), &SVG::rasterize, DEFVAL(0.0f), DEFVAL(0.0f), DEFVAL(1.0f), DEFVAL(RASTER_RGBA8));
+	ClassDB::bind_method(D_METHOD("rasterize_region", "image", "region", "tx", "ty", "scale"), &SVG::rasterize_region, DEFVAL(0.0f), DEFVAL(0.0f), DEFVAL(1.0f));
+	ClassDB::bind_method(D_METHOD("rasterize_bands", "width", "height", "tx", "ty", "scale", "band_height", "target", "method"), &SVG::rasterize_bands);
+	ClassDB::bind_method(D_METHOD("save_png", "path", "width", "height", "tx", "ty", "scale", "band_height"), &SVG::save_png, DEFVAL(0.0f), DEFVAL(0.0f), DEFVAL(1.0f), DEFVAL(256));
+	ClassDB::bind_method(D_METHOD("rasterize_sdf", "width", "height", "tx", "ty", "scale", "spread"), &SVG::rasterize_sdf, DEFVAL(0.0f), DEFVAL(0.0f), DEFVAL(1.0f), DEFVAL(8.0f));
 
 	ADD_PROPERTY(PropertyInfo(Variant::ARRAY, "shapes"), "", "get_shapes");
+
+	BIND_ENUM_CONSTANT(RASTER_RGBA8);
+	BIND_ENUM_CONSTANT(RASTER_RGBA8_PREMULTIPLIED);
+	BIND_ENUM_CONSTANT(RASTER_L8);
+	BIND_ENUM_CONSTANT(RASTER_LA8);
+	BIND_ENUM_CONSTANT(RASTER_RGBA4444);
+	BIND_ENUM_CONSTANT(RASTER_RGBA5551);
 }
 
 /////////////////////////
@@ -303,10 +978,56 @@ void SVGInstance::update_mesh() {
 	}
 }
 
+bool SVGInstance::has_shapes() const {
+
+	for (int i = 0; i < get_child_count(); i++) {
+		if (Object::cast_to<Bezier2D>(get_child(i))) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void SVGInstance::reimport() {
+
+	// parses the svg again and updates the shapes from it.
+
+	svg_pending = false;
+	svg = Ref<SVG>();
+	ERR_FAIL_COND(svg_image.is_null());
+
+	svg.instance();
+	if (svg->load(svg_image->get_path(), "px", 96) != OK) {
+		svg = Ref<SVG>();
+		ERR_FAIL();
+	}
+	update_mesh();
+}
+
+void SVGInstance::_notification(int p_what) {
+
+	switch (p_what) {
+
+		case NOTIFICATION_READY: {
+
+			// scenes set properties before they add the saved children, so
+			// only now can we tell if the shapes were saved with the scene.
+			// these already carry their geometry, so the svg is not parsed
+			// again until reimport() is called.
+			if (svg_pending && !has_shapes()) {
+				reimport();
+			}
+			svg_pending = false;
+
+		} break;
+	}
+}
+
 void SVGInstance::_bind_methods() {
 
 	ClassDB::bind_method(D_METHOD("set_svg"), &SVGInstance::set_svg);
 	ClassDB::bind_method(D_METHOD("get_svg"), &SVGInstance::get_svg);
+	ClassDB::bind_method(D_METHOD("reimport"), &SVGInstance::reimport);
 
 	ADD_PROPERTY(PropertyInfo(Variant::OBJECT, "svg", PROPERTY_HINT_RESOURCE_TYPE, "Texture"), "set_svg", "get_svg");
 }
@@ -320,20 +1041,21 @@ void SVGInstance::set_svg(const Ref<Resource> &p_svg) {
 
 	// this is a hack, as we always get a texture here due to
 	// Godot's default SVG importer being an image importer.
-	if (p_svg.is_valid()) {
-		svg.instance();
-		if (svg->load(p_svg->get_path(), "px", 96) != OK) {
-			svg = Ref<SVG>();
-		} else {
-			update_mesh();
-		}
+	svg_image = p_svg;
+	svg = Ref<SVG>();
+
+	if (p_svg.is_null()) {
+		svg_pending = false;
+	} else if (is_inside_tree()) {
+		reimport();
 	} else {
-		svg_image = Ref<Resource>();
-		svg = Ref<SVG>();
+		svg_pending = true; // decided once the children are known
 	}
 }
 
 SVGInstance::SVGInstance() {
+
+	svg_pending = false;
 }
 
 /////////////////////////
@@ -9,27 +9,118 @@
 #include <nanosvgrast.h>
 
 #include "core/image.h"
+#include "core/os/mutex.h"
 #include "io/resource_loader.h"
 #include "scene/2d/node_2d.h"
 #include "tesselator_2d.h"
 
-class NanoSVG : public Reference {
-	GDCLASS(NanoSVG, Reference);
+class SVGRasterizer;
 
-	NSVGimage *data;
+// nanosvg rasterizers keep scratch memory between calls, but must not be used
+// by two threads at once. the pool hands each caller one for its own use and
+// keeps them around for later calls, instead of setting up a new one each time.
+class SVGRasterizerPool {
+
+	static Mutex *mutex; // NULL on builds without threads
+	static Vector<SVGRasterizer *> rasterizers; // idle ones, at most max_idle
+	static int max_idle;
+	static bool initialized;
 
 public:
-	NSVGimage *get_data() const;
+	static SVGRasterizer *acquire();
+	static void release(SVGRasterizer *p_rasterizer);
 
-	NanoSVG(const String &p_path, const String &p_units, float p_dpi);
-	~NanoSVG();
+	static void initialize();
+	static void finalize();
+};
+
+struct SVGPooledRasterizer {
+	SVGRasterizer *rasterizer;
+
+	SVGPooledRasterizer() { rasterizer = SVGRasterizerPool::acquire(); }
+	~SVGPooledRasterizer() { SVGRasterizerPool::release(rasterizer); }
+};
+
+class SVGData : public Reference {
+	GDCLASS(SVGData, Reference);
+
+public:
+	struct Paint {
+		char type; // NSVG_PAINT_*
+		unsigned int color;
+		int gradient; // index into gradients, or -1
+	};
+
+private:
+	float width;
+	float height;
+
+	// paths of all shapes, stored back to back.
+	Vector<float> points; // x, y pairs, as in NSVGpath::pts
+	Vector<int> path_starts; // first point of each path, plus one past the last
+	Vector<uint8_t> path_closed;
+	Vector<float> path_bounds; // four per path, as in NSVGpath::bounds
+
+	// shapes.
+	Vector<String> shape_ids;
+	Vector<int> shape_path_starts; // first path of each shape, plus one past the last
+	Vector<Paint> shape_fills;
+	Vector<Paint> shape_strokes;
+	Vector<float> shape_opacities;
+	Vector<float> shape_stroke_widths;
+	Vector<uint8_t> shape_fill_rules;
+	Vector<Rect2> shape_bounds;
+
+	// the rest of the stroke style, only needed by the rasterizer.
+	Vector<float> shape_dash_offsets;
+	Vector<float> shape_dash_arrays; // eight per shape, as in NSVGshape::strokeDashArray
+	Vector<uint8_t> shape_dash_counts;
+	Vector<uint8_t> shape_line_joins;
+	Vector<uint8_t> shape_line_caps;
+	Vector<float> shape_miter_limits;
+	Vector<uint8_t> shape_flags;
+
+	Vector<Vector<uint8_t> > gradients; // NSVGgradient with its stops
+
+public:
+	struct View {
+		NSVGimage image;
+		Vector<NSVGshape> shapes;
+		Vector<NSVGpath> paths;
+	};
+
+	Error parse(const String &p_path, const String &p_units, float p_dpi);
+	void make_view(View &r_view, const Rect2 *p_clip = NULL) const;
+
+	float get_width() const;
+	float get_height() const;
+
+	int get_shape_count() const;
+	String get_shape_id(int p_shape) const;
+	int get_shape_path_start(int p_shape) const;
+	int get_shape_path_end(int p_shape) const;
+	const Paint &get_shape_fill(int p_shape) const;
+	const Paint &get_shape_stroke(int p_shape) const;
+	float get_shape_opacity(int p_shape) const;
+	float get_shape_stroke_width(int p_shape) const;
+	int get_shape_fill_rule(int p_shape) const;
+	Rect2 get_shape_bounds(int p_shape) const;
+
+	int get_path_count() const;
+	int get_path_point_count(int p_path) const;
+	const float *get_path_points(int p_path) const;
+	bool is_path_closed(int p_path) const;
+
+	const NSVGgradient *get_gradient(int p_gradient) const;
+
+	SVGData();
 };
 
 class SVGPath : public Reference {
 	GDCLASS(SVGPath, Reference);
 
-	Ref<NanoSVG> svg;
-	const NSVGpath *path;
+	Ref<SVGData> svg;
+	int path;
 
 protected:
 	static void _bind_methods();
@@ -38,14 +129,14 @@ public:
 	bool is_closed() const;
 	Array get_points() const;
 
-	SVGPath(const Ref<NanoSVG> &p_svg, const NSVGpath *p_path);
+	SVGPath(const Ref<SVGData> &p_svg, int p_path);
 };
 
 class SVGShape : public Reference {
 	GDCLASS(SVGShape, Reference);
 
-	Ref<NanoSVG> svg;
-	const NSVGshape *shape;
+	Ref<SVGData> svg;
+	int shape;
 
 protected:
 	static void _bind_methods();
@@ -56,18 +147,32 @@ public:
 	float get_opacity() const;
 	Array get_paths() const;
 
-	SVGShape(const Ref<NanoSVG> &p_svg, const NSVGshape *p_shape);
+	SVGShape(const Ref<SVGData> &p_svg, int p_shape);
 };
 
+// an SVG's parsed data does not change after load(), so all const methods,
+// rasterize() and friends included, may be called on one SVG from several
+// threads at once. load() and update_mesh() must not overlap with anything.
 class SVG : public Resource {
 	GDCLASS(SVG, Resource);
 
-	Ref<NanoSVG> svg;
+	Ref<SVGData> svg;
 
 protected:
 	static void _bind_methods();
 
 public:
+	enum RasterFormat {
+		RASTER_RGBA8,
+		RASTER_RGBA8_PREMULTIPLIED,
+		RASTER_L8, // coverage only
+		RASTER_LA8,
+		RASTER_RGBA4444,
+		RASTER_RGBA5551
+	};
+
+	typedef Error (*BandCallback)(const uint8_t *p_rows, int p_y, int p_height, void *p_userdata);
+
 	Error load(const String &p_path, const String &p_units, float p_dpi);
 
 	float get_width() const;
@@ -76,9 +181,17 @@ public:
 	Array get_shapes() const;
 
 	void update_mesh(Node *p_parent);
-	Ref<Image> rasterize(int p_width, int p_height, float p_tx, float p_ty, float p_scale) const;
+	Ref<Image> rasterize(int p_width, int p_height, float p_tx, float p_ty, float p_scale, RasterFormat p_format = RASTER_RGBA8) const;
+	void rasterize_region(const Ref<Image> &p_image, const Rect2 &p_region, float p_tx, float p_ty, float p_scale) const;
+	Ref<Image> rasterize_sdf(int p_width, int p_height, float p_tx, float p_ty, float p_scale, float p_spread) const;
+	Error rasterize_streamed(int p_width, int p_height, float p_tx, float p_ty, float p_scale, int p_band_height, BandCallback p_callback, void *p_userdata) const;
+	Error rasterize_bands(int p_width, int p_height, float p_tx, float p_ty, float p_scale, int p_band_height, Object *p_target, const StringName &p_method) const;
+	Error save_png(const String &p_path, int p_width, int p_height, float p_tx, float p_ty, float p_scale, int p_band_height) const;
+	void rasterize_to(SVGRasterizer &p_rasterizer, uint8_t *p_dst, int p_width, int p_height, int p_stride, float p_tx, float p_ty, float p_scale) const;
 };
 
+VARIANT_ENUM_CAST(SVG::RasterFormat);
+
 /////////////
 
 class SVGInstance : public Tesselator2D {
@@ -86,16 +199,21 @@ class SVGInstance : public Tesselator2D {
 
 	Ref<Resource> svg_image;
 	Ref<SVG> svg;
+	bool svg_pending; // set while loading, see _notification()
 
 	void update_mesh();
+	bool has_shapes() const;
 
 protected:
+	void _notification(int p_what);
 	static void _bind_methods();
 
 public:
 	Ref<Resource> get_svg() const;
 	void set_svg(const Ref<Resource> &p_svg);
 
+	void reimport();
+
 	SVGInstance();
 };
 
@@ -0,0 +1,150 @@
+/*************************************************************************/
+/*  svg_atlas.cpp                                                        */
+/*************************************************************************/
+
+#include "svg_atlas.h"
+#include "../svg/image_loader_svg.h"
+#include "core/os/copymem.h"
+#include "core/os/os.h"
+#include "core/os/thread.h"
+#include "core/safe_refcount.h"
+#include "core/sort.h"
+
+struct TallerEntry {
+	const int *heights;
+
+	bool operator()(int p_a, int p_b) const {
+		return heights[p_a] > heights[p_b];
+	}
+};
+
+void SVGAtlas::_rasterize_entries(void *p_job) {
+
+	Job *job = (Job *)p_job;
+	const Vector<Entry> &entries = job->entries; // const, so reads never copy on write
+	SVGPooledRasterizer pooled; // one per thread
+	SVGRasterizer &rasterizer = *pooled.rasterizer;
+
+	while (true) {
+		const uint32_t i = atomic_increment(&job->next) - 1;
+		if (i >= (uint32_t)entries.size()) {
+			break;
+		}
+
+		const Entry &entry = entries[i];
+		uint8_t *dst = job->dst + entry.y * job->stride + entry.x * 4;
+		entry.svg->rasterize_to(rasterizer, dst, entry.width, entry.height, job->stride, 0, 0, entry.scale);
+	}
+}
+
+Dictionary SVGAtlas::build(const Array &p_svgs, const Array &p_sizes, int p_max_width, int p_padding) {
+
+	ERR_FAIL_COND_V(p_svgs.size() != p_sizes.size(), Dictionary());
+	ERR_FAIL_COND_V(p_max_width <= 0, Dictionary());
+	ERR_FAIL_COND_V(p_padding < 0, Dictionary());
+
+	const int n = p_svgs.size();
+
+	Job job;
+	job.entries.resize(n);
+
+	Vector<int> heights;
+	heights.resize(n);
+
+	for (int i = 0; i < n; i++) {
+		Entry &entry = job.entries[i];
+		entry.svg = p_svgs[i];
+		ERR_FAIL_COND_V(entry.svg.is_null(), Dictionary());
+		ERR_FAIL_COND_V(entry.svg->get_width() <= 0 || entry.svg->get_height() <= 0, Dictionary());
+
+		const Vector2 size = p_sizes[i];
+		entry.width = Math::ceil(size.x);
+		entry.height = Math::ceil(size.y);
+		ERR_FAIL_COND_V(entry.width <= 0 || entry.height <= 0, Dictionary());
+		ERR_FAIL_COND_V(entry.width + 2 * p_padding > p_max_width, Dictionary());
+
+		entry.scale = MIN(entry.width / entry.svg->get_width(), entry.height / entry.svg->get_height());
+		heights[i] = entry.height;
+	}
+
+	// shelf packing, tallest first, so that shelves waste little height.
+
+	Vector<int> order;
+	order.resize(n);
+	for (int i = 0; i < n; i++) {
+		order[i] = i;
+	}
+
+	SortArray<int, TallerEntry> sorter;
+	sorter.compare.heights = heights.ptr();
+	if (n > 0) {
+		sorter.sort(&order[0], n);
+	}
+
+	int x = 0;
+	int y = 0;
+	int shelf_height = 0;
+	for (int i = 0; i < n; i++) {
+		Entry &entry = job.entries[order[i]];
+
+		const int w = entry.width + 2 * p_padding;
+		const int h = entry.height + 2 * p_padding;
+		if (x + w > p_max_width) {
+			x = 0;
+			y += shelf_height;
+			shelf_height = 0;
+		}
+
+		entry.x = x + p_padding;
+		entry.y = y + p_padding;
+		x += w;
+		shelf_height = MAX(shelf_height, h);
+	}
+
+	const int width = p_max_width;
+	const int height = next_power_of_2(MAX(y + shelf_height, 1));
+
+	PoolVector<uint8_t> data;
+	data.resize(width * height * 4);
+	PoolVector<uint8_t>::Write w = data.write();
+	zeromem(w.ptr(), width * height * 4); // padding and unused space stay transparent
+
+	// all threads rasterize into the one buffer, each into its own regions.
+
+	job.dst = w.ptr();
+	job.stride = width * 4;
+	job.next = 0;
+
+	const int n_threads = MIN(OS::get_singleton()->get_processor_count(), n) - 1;
+	Vector<Thread *> threads;
+	for (int i = 0; i < n_threads; i++) {
+		threads.push_back(Thread::create(_rasterize_entries, &job));
+	}
+	_rasterize_entries(&job);
+	for (int i = 0; i < threads.size(); i++) {
+		Thread::wait_to_finish(threads[i]);
+		memdelete(threads[i]);
+	}
+
+	w = PoolVector<uint8_t>::Write();
+
+	Ref<Image> image;
+	image.instance();
+	image->create(width, height, false, Image::FORMAT_RGBA8, data);
+
+	Array regions;
+	for (int i = 0; i < n; i++) {
+		const Entry &entry = job.entries[i];
+		regions.push_back(Rect2(entry.x, entry.y, entry.width, entry.height));
+	}
+
+	Dictionary atlas;
+	atlas["image"] = image;
+	atlas["regions"] = regions;
+	return atlas;
+}
+
+void SVGAtlas::_bind_methods() {
+
+	ClassDB::bind_method(D_METHOD("build", "svgs", "sizes", "max_width", "padding"), &SVGAtlas::build, DEFVAL(2048), DEFVAL(1));
+}
@@ -0,0 +1,38 @@
+/*************************************************************************/
+/*  svg_atlas.h                                                          */
+/*************************************************************************/
+
+#ifndef SVG_ATLAS_H
+#define SVG_ATLAS_H
+
+#include "svg.h"
+
+class SVGAtlas : public Reference {
+	GDCLASS(SVGAtlas, Reference);
+
+	struct Entry {
+		Ref<SVG> svg;
+		int width;
+		int height;
+		int x;
+		int y;
+		float scale;
+	};
+
+	struct Job {
+		Vector<Entry> entries;
+		uint8_t *dst;
+		int stride;
+		uint32_t next; // index of the next entry to rasterize
+	};
+
+	static void _rasterize_entries(void *p_job);
+
+protected:
+	static void _bind_methods();
+
+public:
+	Dictionary build(const Array &p_svgs, const Array &p_sizes, int p_max_width, int p_padding);
+};
+
+#endif // SVG_ATLAS_H
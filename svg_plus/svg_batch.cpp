@@ -0,0 +1,246 @@
+/*************************************************************************/
+/*  svg_batch.cpp                                                        */
+/*************************************************************************/
+
+#include "svg_batch.h"
+#include "core/io/json.h"
+#include "core/io/resource_saver.h"
+#include "core/os/file_access.h"
+#include "core/os/os.h"
+#include "core/os/thread.h"
+#include "core/safe_refcount.h"
+#include "scene/resources/packed_scene.h"
+
+// converts the SVGs listed in a json manifest:
+//
+// { "jobs": [ { "input": "res://icon.svg", "png": "res://out/icon.png",
+//               "width": 64, "height": 64,
+//               "mesh": "res://out/icon.tscn", "quality": 100 } ] }
+//
+// images are rasterized on all cores. meshes need a scene tree and are built
+// on the calling thread afterwards, one file at a time, but each file's shapes
+// are tesselated on all cores. outputs whose input and settings did not
+// change since the last run, according to a .md5 file next to them, are
+// skipped.
+
+bool SVGBatchConverter::_is_unchanged(const String &p_output, const String &p_hash) {
+
+	if (!FileAccess::exists(p_output)) {
+		return false;
+	}
+
+	FileAccess *f = FileAccess::open(p_output + ".md5", FileAccess::READ);
+	if (!f) {
+		return false;
+	}
+	const String hash = f->get_line();
+	memdelete(f);
+
+	return hash == p_hash;
+}
+
+void SVGBatchConverter::_mark_unchanged(const String &p_output, const String &p_hash) {
+
+	FileAccess *f = FileAccess::open(p_output + ".md5", FileAccess::WRITE);
+	ERR_FAIL_COND(!f);
+	f->store_line(p_hash);
+	memdelete(f);
+}
+
+void SVGBatchConverter::_convert_images(void *p_queue) {
+
+	Queue *queue = (Queue *)p_queue;
+
+	while (true) {
+		const uint32_t i = atomic_increment(&queue->next) - 1;
+		if (i >= (uint32_t)queue->n_jobs) {
+			break;
+		}
+
+		// each index is handed out once, so this thread owns the job.
+		Job &job = queue->jobs[i];
+
+		// each output only depends on its own settings, so changing the
+		// quality does not redo the image, nor the size the mesh.
+		const String input_md5 = FileAccess::get_md5(job.input);
+		job.png_hash = (input_md5 + " " + itos(job.width) + "x" + itos(job.height)).md5_text();
+		job.mesh_hash = (input_md5 + " " + rtos(job.quality)).md5_text();
+
+		const bool png_done = job.png.empty() || _is_unchanged(job.png, job.png_hash);
+		const bool mesh_done = job.mesh.empty() || _is_unchanged(job.mesh, job.mesh_hash);
+		job.png_status = png_done ? STATUS_SKIPPED : STATUS_PENDING;
+		job.mesh_status = mesh_done ? STATUS_SKIPPED : STATUS_PENDING;
+
+		if (png_done && mesh_done) {
+			continue;
+		}
+
+		job.svg.instance();
+		if (job.svg->load(job.input, "px", 96) != OK) {
+			job.svg = Ref<SVG>();
+			job.png_status = png_done ? STATUS_SKIPPED : STATUS_FAILED;
+			job.mesh_status = mesh_done ? STATUS_SKIPPED : STATUS_FAILED;
+			continue;
+		}
+
+		if (png_done) {
+			continue;
+		}
+
+		const float scale = MIN(job.width / job.svg->get_width(), job.height / job.svg->get_height());
+		Ref<Image> image = job.svg->rasterize(job.width, job.height, 0, 0, scale);
+		if (image.is_valid() && image->save_png(job.png) == OK) {
+			_mark_unchanged(job.png, job.png_hash);
+			job.png_status = STATUS_CONVERTED;
+		} else {
+			job.png_status = STATUS_FAILED;
+		}
+
+		if (mesh_done) {
+			job.svg = Ref<SVG>(); // done with it, no need to hold it until the end
+		}
+	}
+}
+
+SVGBatchConverter::Status SVGBatchConverter::_convert_mesh(Job &p_job, Node *p_parent) {
+
+	Tesselator2D *root = memnew(Tesselator2D);
+	root->set_name(p_job.input.get_file().get_basename());
+	root->set_quality(p_job.quality);
+	root->set_store_tesselation(true);
+
+	// shapes only register with their tesselator inside a tree.
+	p_parent->add_child(root);
+	p_job.svg->update_mesh(root);
+	for (int i = 0; i < root->get_child_count(); i++) {
+		root->get_child(i)->set_owner(root);
+	}
+
+	root->tesselate(); // the scene only stores finished tesselations
+
+	Ref<PackedScene> scene;
+	scene.instance();
+	Error err = scene->pack(root);
+	if (err == OK) {
+		err = ResourceSaver::save(p_job.mesh, scene);
+	}
+
+	p_parent->remove_child(root);
+	memdelete(root);
+
+	if (err != OK) {
+		return STATUS_FAILED;
+	}
+
+	_mark_unchanged(p_job.mesh, p_job.mesh_hash);
+	return STATUS_CONVERTED;
+}
+
+Dictionary SVGBatchConverter::convert(const String &p_manifest, Node *p_parent) {
+
+	Dictionary result;
+
+	Error err;
+	const String text = FileAccess::get_file_as_string(p_manifest, &err);
+	ERR_FAIL_COND_V(err != OK, result);
+
+	Variant manifest;
+	String error_string;
+	int error_line;
+	err = JSON::parse(text, manifest, error_string, error_line);
+	if (err != OK) {
+		ERR_PRINTS(p_manifest + ":" + itos(error_line) + ": " + error_string);
+		return result;
+	}
+	ERR_FAIL_COND_V(manifest.get_type() != Variant::DICTIONARY, result);
+
+	const Array entries = Dictionary(manifest).get("jobs", Array());
+
+	Vector<Job> jobs;
+	for (int i = 0; i < entries.size(); i++) {
+		const Dictionary entry = entries[i];
+
+		Job job;
+		job.input = entry.get("input", "");
+		job.png = entry.get("png", "");
+		job.mesh = entry.get("mesh", "");
+		job.width = entry.get("width", 0);
+		job.height = entry.get("height", 0);
+		job.quality = entry.get("quality", 100);
+		job.png_status = STATUS_PENDING;
+		job.mesh_status = STATUS_PENDING;
+
+		ERR_CONTINUE(job.input.empty());
+		ERR_CONTINUE(!job.png.empty() && (job.width <= 0 || job.height <= 0));
+		jobs.push_back(job);
+	}
+
+	if (jobs.empty()) {
+		return result;
+	}
+
+	Queue queue;
+	queue.jobs = &jobs[0];
+	queue.n_jobs = jobs.size();
+	queue.next = 0;
+
+	// threads pull the next job from a shared counter, so a few large files
+	// do not hold up the small ones behind them.
+	const int n_threads = MIN(OS::get_singleton()->get_processor_count(), queue.n_jobs) - 1;
+	Vector<Thread *> threads;
+	for (int i = 0; i < n_threads; i++) {
+		threads.push_back(Thread::create(_convert_images, &queue));
+	}
+	_convert_images(&queue);
+	for (int i = 0; i < threads.size(); i++) {
+		Thread::wait_to_finish(threads[i]);
+		memdelete(threads[i]);
+	}
+
+	int converted = 0;
+	int skipped = 0;
+	int failed = 0;
+	Array failures;
+
+	for (int i = 0; i < jobs.size(); i++) {
+		Job &job = jobs[i];
+
+		if (job.mesh_status == STATUS_PENDING) {
+			job.mesh_status = p_parent ? _convert_mesh(job, p_parent) : STATUS_FAILED;
+		}
+		job.svg = Ref<SVG>();
+
+		const bool requested[2] = { !job.png.empty(), !job.mesh.empty() };
+		const Status statuses[2] = { job.png_status, job.mesh_status };
+		for (int j = 0; j < 2; j++) {
+			if (!requested[j]) {
+				continue;
+			}
+			switch (statuses[j]) {
+				case STATUS_CONVERTED: {
+					converted++;
+				} break;
+				case STATUS_SKIPPED: {
+					skipped++;
+				} break;
+				default: {
+					failed++;
+				} break;
+			}
+		}
+		if (job.png_status == STATUS_FAILED || job.mesh_status == STATUS_FAILED) {
+			failures.push_back(job.input);
+		}
+	}
+
+	result["converted"] = converted;
+	result["skipped"] = skipped;
+	result["failed"] = failed;
+	result["failures"] = failures;
+	return result;
+}
+
+void SVGBatchConverter::_bind_methods() {
+
+	ClassDB::bind_method(D_METHOD("convert", "manifest", "parent"), &SVGBatchConverter::convert);
+}
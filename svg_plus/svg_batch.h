@@ -0,0 +1,54 @@
+/*************************************************************************/
+/*  svg_batch.h                                                          */
+/*************************************************************************/
+
+#ifndef SVG_BATCH_H
+#define SVG_BATCH_H
+
+#include "svg.h"
+
+class SVGBatchConverter : public Reference {
+	GDCLASS(SVGBatchConverter, Reference);
+
+	enum Status {
+		STATUS_PENDING,
+		STATUS_CONVERTED,
+		STATUS_SKIPPED,
+		STATUS_FAILED
+	};
+
+	struct Job {
+		String input;
+		String png; // empty if no image is wanted
+		String mesh; // empty if no scene is wanted
+		int width;
+		int height;
+		float quality;
+
+		String png_hash; // of the input file and the settings of each output
+		String mesh_hash;
+		Ref<SVG> svg;
+		Status png_status;
+		Status mesh_status;
+	};
+
+	struct Queue {
+		Job *jobs;
+		int n_jobs;
+		uint32_t next;
+	};
+
+	static void _convert_images(void *p_queue);
+	static bool _is_unchanged(const String &p_output, const String &p_hash);
+	static void _mark_unchanged(const String &p_output, const String &p_hash);
+
+	Status _convert_mesh(Job &p_job, Node *p_parent);
+
+protected:
+	static void _bind_methods();
+
+public:
+	Dictionary convert(const String &p_manifest, Node *p_parent);
+};
+
+#endif // SVG_BATCH_H
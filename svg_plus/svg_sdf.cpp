@@ -0,0 +1,309 @@
+/*************************************************************************/
+/*  svg_sdf.cpp                                                          */
+/*************************************************************************/
+
+#include "core/os/os.h"
+#include "core/os/thread.h"
+#include "core/safe_refcount.h"
+#include "core/sort.h"
+#include "svg.h"
+#include "thirdparty/misc/clipper.hpp"
+
+// signed distance fields from the flattened fill outlines. the sign comes
+// from a scanline pass per row, the distance from a pass over tiles that only
+// look at the segments near them. both passes run on all cores.
+//
+// distances are measured to the boundary of the union of all fills, so that
+// edges inside other shapes do not show up as contours within the union.
+
+static const int SDF_TILE_SIZE = 32;
+static const float SDF_CLIPPER_SCALE = 256.0; // subpixel precision of the union
+
+struct SDFSegment {
+	Vector2 a;
+	Vector2 b;
+};
+
+struct SDFCrossing {
+	float x;
+	int direction;
+
+	bool operator<(const SDFCrossing &p_other) const {
+		return x < p_other.x;
+	}
+};
+
+struct SDFJob {
+	Vector<SDFSegment> segments;
+	Vector<int> shape_starts; // segments of shape i are [shape_starts[i], shape_starts[i + 1])
+	Vector<uint8_t> shape_evenodd;
+	Vector<SDFSegment> boundary; // of the union of all shapes, for distances
+
+	const uint8_t *evenodd; // shape_evenodd, taken before the threads start
+
+	int width;
+	int height;
+	float spread;
+
+	uint8_t *inside; // per pixel, from the scanline pass
+	uint8_t *dst;
+
+	uint32_t next;
+	void (*run)(SDFJob *p_job, int p_item);
+	int n_items;
+};
+
+static void sdf_worker(void *p_job) {
+
+	SDFJob *job = (SDFJob *)p_job;
+	while (true) {
+		const uint32_t i = atomic_increment(&job->next) - 1;
+		if (i >= (uint32_t)job->n_items) {
+			break;
+		}
+		job->run(job, i);
+	}
+}
+
+static void sdf_run_parallel(SDFJob &p_job, void (*p_run)(SDFJob *, int), int p_n_items) {
+
+	p_job.run = p_run;
+	p_job.n_items = p_n_items;
+	p_job.next = 0;
+
+	const int n_threads = MIN(OS::get_singleton()->get_processor_count(), p_n_items) - 1;
+	Vector<Thread *> threads;
+	for (int i = 0; i < n_threads; i++) {
+		threads.push_back(Thread::create(sdf_worker, &p_job));
+	}
+	sdf_worker(&p_job);
+	for (int i = 0; i < threads.size(); i++) {
+		Thread::wait_to_finish(threads[i]);
+		memdelete(threads[i]);
+	}
+}
+
+static void sdf_scan_row(SDFJob *p_job, int p_row) {
+
+	const Vector<SDFSegment> &segments = p_job->segments;
+	const Vector<int> &starts = p_job->shape_starts;
+	const float cy = p_row + 0.5;
+	uint8_t *inside = p_job->inside + p_row * p_job->width;
+
+	Vector<SDFCrossing> crossings;
+	for (int shape = 0; shape + 1 < starts.size(); shape++) {
+
+		crossings.clear();
+		for (int i = starts[shape]; i < starts[shape + 1]; i++) {
+			const SDFSegment &s = segments[i];
+			if ((s.a.y <= cy) != (s.b.y <= cy)) {
+				SDFCrossing crossing;
+				crossing.x = s.a.x + (cy - s.a.y) * (s.b.x - s.a.x) / (s.b.y - s.a.y);
+				crossing.direction = s.b.y > s.a.y ? 1 : -1;
+				crossings.push_back(crossing);
+			}
+		}
+
+		if (crossings.size() < 2) {
+			continue;
+		}
+		crossings.sort();
+
+		const bool evenodd = p_job->evenodd[shape];
+		int winding = 0;
+		for (int i = 0; i + 1 < crossings.size(); i++) {
+			winding += crossings[i].direction;
+			if (evenodd ? (winding & 1) == 0 : winding == 0) {
+				continue;
+			}
+
+			// pixels whose centers lie in [x0, x1).
+			const int x0 = MAX(int(Math::ceil(crossings[i].x - 0.5)), 0);
+			const int x1 = MIN(int(Math::ceil(crossings[i + 1].x - 0.5)), p_job->width);
+			for (int x = x0; x < x1; x++) {
+				inside[x] = 1;
+			}
+		}
+	}
+}
+
+static void sdf_distance_tile(SDFJob *p_job, int p_tile) {
+
+	const int tiles_x = (p_job->width + SDF_TILE_SIZE - 1) / SDF_TILE_SIZE;
+	const int tx = (p_tile % tiles_x) * SDF_TILE_SIZE;
+	const int ty = (p_tile / tiles_x) * SDF_TILE_SIZE;
+	const int tw = MIN(SDF_TILE_SIZE, p_job->width - tx);
+	const int th = MIN(SDF_TILE_SIZE, p_job->height - ty);
+	const float spread = p_job->spread;
+
+	// only segments that can be within spread of this tile matter.
+	const Rect2 area = Rect2(tx, ty, tw, th).grow(spread);
+	const Vector<SDFSegment> &segments = p_job->boundary;
+	Vector<SDFSegment> near;
+	for (int i = 0; i < segments.size(); i++) {
+		const SDFSegment &s = segments[i];
+		const Rect2 r = Rect2(s.a, Vector2()).expand(s.b);
+		if (r.position.x <= area.position.x + area.size.x && r.position.x + r.size.x >= area.position.x &&
+				r.position.y <= area.position.y + area.size.y && r.position.y + r.size.y >= area.position.y) {
+			near.push_back(s);
+		}
+	}
+
+	const SDFSegment *near_ptr = near.empty() ? NULL : &near[0];
+	const int n_near = near.size();
+
+	for (int y = ty; y < ty + th; y++) {
+		for (int x = tx; x < tx + tw; x++) {
+			const Vector2 p(x + 0.5, y + 0.5);
+
+			real_t d2 = spread * spread;
+			for (int i = 0; i < n_near; i++) {
+				const Vector2 ab = near_ptr[i].b - near_ptr[i].a;
+				const Vector2 ap = p - near_ptr[i].a;
+				const real_t l2 = ab.length_squared();
+				const real_t t = l2 > 0 ? CLAMP(ap.dot(ab) / l2, 0, 1) : 0;
+				d2 = MIN(d2, (ap - ab * t).length_squared());
+			}
+
+			const int k = y * p_job->width + x;
+			const real_t d = p_job->inside[k] ? Math::sqrt(d2) : -Math::sqrt(d2);
+			p_job->dst[k] = CLAMP(Math::round((0.5 + 0.5 * d / spread) * 255.0), 0, 255);
+		}
+	}
+}
+
+static void sdf_flatten_cubic(const Vector2 &p_p0, const Vector2 &p_p1, const Vector2 &p_p2, const Vector2 &p_p3, Vector<SDFSegment> &r_segments) {
+
+	// the control polygon's length bounds the curve's, which is good
+	// enough to pick a step count at pixel scale.
+	const real_t length = p_p0.distance_to(p_p1) + p_p1.distance_to(p_p2) + p_p2.distance_to(p_p3);
+	const int n = CLAMP(int(Math::ceil(Math::sqrt(length))), 1, 64);
+
+	Vector2 a = p_p0;
+	for (int i = 1; i <= n; i++) {
+		const real_t t = real_t(i) / n;
+		const real_t u = 1 - t;
+		const Vector2 b = p_p0 * (u * u * u) + p_p1 * (3 * u * u * t) + p_p2 * (3 * u * t * t) + p_p3 * (t * t * t);
+
+		SDFSegment segment;
+		segment.a = a;
+		segment.b = b;
+		r_segments.push_back(segment);
+		a = b;
+	}
+}
+
+Ref<Image> SVG::rasterize_sdf(int p_width, int p_height, float p_tx, float p_ty, float p_scale, float p_spread) const {
+
+	ERR_FAIL_COND_V(!svg.is_valid(), Ref<Image>());
+	ERR_FAIL_COND_V(p_width <= 0, Ref<Image>());
+	ERR_FAIL_COND_V(p_height <= 0, Ref<Image>());
+	ERR_FAIL_COND_V(p_spread <= 0, Ref<Image>());
+
+	SDFJob job;
+	job.width = p_width;
+	job.height = p_height;
+	job.spread = p_spread;
+
+	// filled outlines in pixel space. paths are always closed for filling.
+	// each shape's outlines are also resolved with its fill rule, for the union.
+
+	ClipperLib::Paths resolved;
+
+	const Vector2 t(p_tx, p_ty);
+	for (int shape = 0; shape < svg->get_shape_count(); shape++) {
+		if (svg->get_shape_fill(shape).type == NSVG_PAINT_NONE) {
+			continue;
+		}
+
+		const bool evenodd = svg->get_shape_fill_rule(shape) == NSVG_FILLRULE_EVENODD;
+		job.shape_starts.push_back(job.segments.size());
+		job.shape_evenodd.push_back(evenodd);
+
+		ClipperLib::Paths shape_paths;
+
+		const int path_end = svg->get_shape_path_end(shape);
+		for (int path = svg->get_shape_path_start(shape); path < path_end; path++) {
+			const int n = svg->get_path_point_count(path);
+			const float *pts = svg->get_path_points(path);
+			if (n < 4) {
+				continue;
+			}
+
+			const int first = job.segments.size();
+
+			for (int i = 0; i + 3 < n; i += 3) {
+				sdf_flatten_cubic(
+						Vector2(pts[2 * i + 0], pts[2 * i + 1]) * p_scale + t,
+						Vector2(pts[2 * i + 2], pts[2 * i + 3]) * p_scale + t,
+						Vector2(pts[2 * i + 4], pts[2 * i + 5]) * p_scale + t,
+						Vector2(pts[2 * i + 6], pts[2 * i + 7]) * p_scale + t,
+						job.segments);
+			}
+
+			SDFSegment closing;
+			closing.a = Vector2(pts[2 * (n - 1) + 0], pts[2 * (n - 1) + 1]) * p_scale + t;
+			closing.b = Vector2(pts[0], pts[1]) * p_scale + t;
+			if (closing.a != closing.b) {
+				job.segments.push_back(closing);
+			}
+
+			ClipperLib::Path clipper_path;
+			for (int i = first; i < job.segments.size(); i++) {
+				const Vector2 &a = job.segments[i].a;
+				clipper_path.push_back(ClipperLib::IntPoint(Math::round(a.x * SDF_CLIPPER_SCALE), Math::round(a.y * SDF_CLIPPER_SCALE)));
+			}
+			shape_paths.push_back(clipper_path);
+		}
+
+		ClipperLib::Paths simple;
+		ClipperLib::SimplifyPolygons(shape_paths, simple, evenodd ? ClipperLib::pftEvenOdd : ClipperLib::pftNonZero);
+		for (int i = 0; i < simple.size(); i++) {
+			resolved.push_back(simple[i]);
+		}
+	}
+	job.shape_starts.push_back(job.segments.size());
+	job.evenodd = job.shape_evenodd.empty() ? NULL : job.shape_evenodd.ptr();
+
+	ClipperLib::Clipper clipper;
+	clipper.AddPaths(resolved, ClipperLib::ptSubject, true);
+	ClipperLib::Paths outline;
+	clipper.Execute(ClipperLib::ctUnion, outline, ClipperLib::pftNonZero, ClipperLib::pftNonZero);
+
+	for (int i = 0; i < outline.size(); i++) {
+		const ClipperLib::Path &path = outline[i];
+		for (int j = 0; j < path.size(); j++) {
+			const ClipperLib::IntPoint &a = path[j];
+			const ClipperLib::IntPoint &b = path[(j + 1) % path.size()];
+			SDFSegment segment;
+			segment.a = Vector2(a.X, a.Y) / SDF_CLIPPER_SCALE;
+			segment.b = Vector2(b.X, b.Y) / SDF_CLIPPER_SCALE;
+			job.boundary.push_back(segment);
+		}
+	}
+
+	Vector<uint8_t> inside;
+	inside.resize(p_width * p_height);
+	for (int i = 0; i < inside.size(); i++) {
+		inside[i] = 0;
+	}
+	job.inside = &inside[0];
+
+	PoolVector<uint8_t> data;
+	data.resize(p_width * p_height);
+	PoolVector<uint8_t>::Write w = data.write();
+	job.dst = w.ptr();
+
+	sdf_run_parallel(job, sdf_scan_row, p_height);
+
+	const int tiles_x = (p_width + SDF_TILE_SIZE - 1) / SDF_TILE_SIZE;
+	const int tiles_y = (p_height + SDF_TILE_SIZE - 1) / SDF_TILE_SIZE;
+	sdf_run_parallel(job, sdf_distance_tile, tiles_x * tiles_y);
+
+	w = PoolVector<uint8_t>::Write();
+
+	Ref<Image> image;
+	image.instance();
+	image->create(p_width, p_height, false, Image::FORMAT_L8, data);
+	return image;
+}
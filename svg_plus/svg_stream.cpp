@@ -0,0 +1,205 @@
+/*************************************************************************/
+/*  svg_stream.cpp                                                       */
+/*************************************************************************/
+
+#include "../svg/image_loader_svg.h"
+#include "core/os/copymem.h"
+#include "core/os/os.h"
+#include "core/os/thread.h"
+#include "core/os/file_access.h"
+#include "svg.h"
+
+#include <png.h>
+
+// rasterizes outputs too large for one buffer as horizontal bands. up to one
+// band per core is rasterized at a time, and the bands are handed on in
+// order, so memory stays at cores * band size.
+
+struct SVGBand {
+	const SVG *svg;
+	uint8_t *dst;
+	int width;
+	int height;
+	float tx;
+	float ty;
+	float scale;
+};
+
+static void rasterize_band(void *p_band) {
+
+	const SVGBand *band = (const SVGBand *)p_band;
+	SVGPooledRasterizer pooled;
+	band->svg->rasterize_to(*pooled.rasterizer, band->dst, band->width, band->height, band->width * 4, band->tx, band->ty, band->scale);
+}
+
+Error SVG::rasterize_streamed(int p_width, int p_height, float p_tx, float p_ty, float p_scale, int p_band_height, BandCallback p_callback, void *p_userdata) const {
+
+	ERR_FAIL_COND_V(!svg.is_valid(), ERR_UNCONFIGURED);
+	ERR_FAIL_COND_V(p_width <= 0 || p_height <= 0, ERR_INVALID_PARAMETER);
+	ERR_FAIL_COND_V(p_band_height <= 0, ERR_INVALID_PARAMETER);
+
+	// buffers are indexed by int, so one band has to fit, and there are
+	// only as many slots as fit along with it.
+	const int64_t band_size = int64_t(p_width) * MIN(p_band_height, p_height) * 4;
+	ERR_FAIL_COND_V(band_size > INT32_MAX, ERR_INVALID_PARAMETER);
+
+	const int n_bands = (p_height - 1) / p_band_height + 1;
+	const int max_slots = INT32_MAX / band_size;
+	const int n_slots = CLAMP(OS::get_singleton()->get_processor_count(), 1, MIN(n_bands, max_slots));
+
+	Vector<uint8_t> buffer;
+	buffer.resize(n_slots * band_size);
+
+	Vector<SVGBand> bands;
+	bands.resize(n_slots);
+
+	for (int first = 0; first < n_bands; first += n_slots) {
+
+		const int n = MIN(n_slots, n_bands - first);
+		for (int i = 0; i < n; i++) {
+			const int y = (first + i) * p_band_height;
+			SVGBand &band = bands[i];
+			band.svg = this;
+			band.dst = &buffer[i * int(band_size)];
+			band.width = p_width;
+			band.height = MIN(p_band_height, p_height - y);
+			band.tx = p_tx;
+			band.ty = p_ty - y;
+			band.scale = p_scale;
+		}
+
+		Vector<Thread *> threads;
+		for (int i = 1; i < n; i++) {
+			threads.push_back(Thread::create(rasterize_band, &bands[i]));
+		}
+		rasterize_band(&bands[0]);
+		for (int i = 0; i < threads.size(); i++) {
+			Thread::wait_to_finish(threads[i]);
+			memdelete(threads[i]);
+		}
+
+		for (int i = 0; i < n; i++) {
+			const Error err = p_callback(bands[i].dst, (first + i) * p_band_height, bands[i].height, p_userdata);
+			if (err != OK) {
+				return err;
+			}
+		}
+	}
+
+	return OK;
+}
+
+struct SVGBandTarget {
+	Object *target;
+	StringName method;
+	int width;
+};
+
+static Error emit_band(const uint8_t *p_rows, int p_y, int p_height, void *p_userdata) {
+
+	const SVGBandTarget *target = (const SVGBandTarget *)p_userdata;
+
+	PoolVector<uint8_t> data;
+	data.resize(target->width * p_height * 4);
+	{
+		PoolVector<uint8_t>::Write w = data.write();
+		copymem(w.ptr(), p_rows, target->width * p_height * 4);
+	}
+
+	Ref<Image> band;
+	band.instance();
+	band->create(target->width, p_height, false, Image::FORMAT_RGBA8, data);
+
+	target->target->call(target->method, band, p_y);
+	return OK;
+}
+
+Error SVG::rasterize_bands(int p_width, int p_height, float p_tx, float p_ty, float p_scale, int p_band_height, Object *p_target, const StringName &p_method) const {
+
+	ERR_FAIL_NULL_V(p_target, ERR_INVALID_PARAMETER);
+
+	SVGBandTarget target;
+	target.target = p_target;
+	target.method = p_method;
+	target.width = p_width;
+
+	return rasterize_streamed(p_width, p_height, p_tx, p_ty, p_scale, p_band_height, emit_band, &target);
+}
+
+struct SVGPNGWriter {
+	png_structp png;
+	png_infop info;
+	int width;
+};
+
+static void png_write_file(png_structp p_png, png_bytep p_data, png_size_t p_length) {
+
+	FileAccess *f = (FileAccess *)png_get_io_ptr(p_png);
+	f->store_buffer(p_data, p_length);
+}
+
+static void png_flush_file(png_structp p_png) {
+
+	FileAccess *f = (FileAccess *)png_get_io_ptr(p_png);
+	f->flush();
+}
+
+static Error write_png_band(const uint8_t *p_rows, int p_y, int p_height, void *p_userdata) {
+
+	SVGPNGWriter *writer = (SVGPNGWriter *)p_userdata;
+
+	if (setjmp(png_jmpbuf(writer->png))) {
+		return ERR_FILE_CANT_WRITE;
+	}
+
+	for (int i = 0; i < p_height; i++) {
+		png_write_row(writer->png, (png_bytep)(p_rows + i * writer->width * 4));
+	}
+	return OK;
+}
+
+Error SVG::save_png(const String &p_path, int p_width, int p_height, float p_tx, float p_ty, float p_scale, int p_band_height) const {
+
+	ERR_FAIL_COND_V(p_width <= 0 || p_height <= 0, ERR_INVALID_PARAMETER);
+
+	Error err;
+	FileAccess *f = FileAccess::open(p_path, FileAccess::WRITE, &err);
+	ERR_FAIL_COND_V(err != OK, err);
+
+	SVGPNGWriter writer;
+	writer.width = p_width;
+	writer.png = png_create_write_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+	writer.info = writer.png ? png_create_info_struct(writer.png) : NULL;
+	if (!writer.info) {
+		png_destroy_write_struct(&writer.png, NULL);
+		memdelete(f);
+		ERR_FAIL_V(ERR_OUT_OF_MEMORY);
+	}
+
+	if (setjmp(png_jmpbuf(writer.png))) {
+		png_destroy_write_struct(&writer.png, &writer.info);
+		memdelete(f);
+		ERR_FAIL_V(ERR_FILE_CANT_WRITE);
+	}
+
+	png_set_write_fn(writer.png, f, png_write_file, png_flush_file);
+	png_set_IHDR(writer.png, writer.info, p_width, p_height, 8, PNG_COLOR_TYPE_RGB_ALPHA,
+			PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+	png_write_info(writer.png, writer.info);
+
+	// rows are written as soon as their band is done, the image never
+	// exists as a whole.
+	err = rasterize_streamed(p_width, p_height, p_tx, p_ty, p_scale, p_band_height, write_png_band, &writer);
+
+	if (err == OK && !setjmp(png_jmpbuf(writer.png))) {
+		png_write_end(writer.png, NULL);
+	} else if (err == OK) {
+		err = ERR_FILE_CANT_WRITE;
+	}
+
+	png_destroy_write_struct(&writer.png, &writer.info);
+	f->close();
+	memdelete(f);
+
+	return err;
+}
@@ -5,11 +5,44 @@
 #ifndef TESSELATOR_2D_H
 #define TESSELATOR_2D_H
 
+#include "core/os/mutex.h"
+#include "core/os/semaphore.h"
+#include "core/os/thread.h"
 #include "scene/2d/node_2d.h"
 #include "thirdparty/misc/clipper.hpp"
 
 class Bezier2D;
 
+// threads for tesselation work, started once with the module. run() hands
+// out the indices of a batch to them and to the calling thread, and returns
+// when all are done. without threads, it simply runs the batch itself.
+class TesselationWorkerPool {
+
+public:
+	typedef void (*Function)(void *p_userdata, int p_index);
+
+private:
+	static Vector<Thread *> threads;
+	static Mutex *mutex; // one batch at a time
+	static Semaphore *start;
+	static Semaphore *done;
+	static bool exiting;
+
+	static Function function;
+	static void *userdata;
+	static int count;
+	static uint32_t next;
+
+	static void _work();
+	static void _thread(void *p_userdata);
+
+public:
+	static void run(Function p_function, void *p_userdata, int p_count);
+
+	static void initialize();
+	static void finalize();
+};
+
 class Tesselator2D : public Node2D {
 
 	GDCLASS(Tesselator2D, Node2D);
@@ -26,41 +59,179 @@ public:
 		int max_levels; // for bezier flattening
 	};
 
+	struct Mesh {
+		Vector<Vector2> vertices;
+		Vector<int> indices;
+		Vector<real_t> coverage; // per vertex alpha, empty for solid meshes
+		Vector<Vector2> normals; // fringes only, moves a vertex out by one pixel of width
+	};
+
 	struct Tesselation {
 		Polygons fill;
 		Polygons stroke;
+		Mesh fill_mesh; // triangulated once, drawn as is
+		Mesh stroke_mesh;
+		Mesh fill_fringe; // alpha fading edge strips for antialiasing
+		Mesh stroke_fringe;
+		Polygons outline; // closed fill outlines for hairline strokes
 		Rect2 bounds;
+		Vector2 origin; // translation of the (possibly shared) geometry
+		uint32_t version; // changes whenever the geometry does
+
+		Tesselation() {
+			version = 0;
+		}
 	};
 
 private:
+	struct Instance {
+		Vector<real_t> key;
+		int users;
+		Tesselation tesselation;
+	};
+
+	struct Collision {
+		float tolerance;
+		bool convex;
+		Polygons polygons;
+	};
+
 	struct Cache {
 		NodePath path;
 		bool valid;
-		IntPolygons base;
+		bool instanced;
+		uint32_t instance;
+		IntPolygons base; // unsimplified fill in path space, for meld and collisions
+		IntPolygons fill; // simplified outlines, kept for occlusion culling and meld
+		IntPolygons stroke;
+		bool melded; // fill and stroke are the meld's result, kept while culled
+		IntPolygons visible_fill; // fill and stroke as clipped by the last occlusion pass
+		IntPolygons visible_stroke;
+		uint32_t visible_version; // of the tesselation built from them, 0 if none
+		Tesselation tesselation;
+		Vector<Collision> collisions; // dropped whenever the geometry changes
+	};
+
+	struct Stored {
+		Vector<real_t> key; // see _get_input_key()
+		IntPolygons fill;
+		IntPolygons stroke;
+		Tesselation tesselation;
+	};
+
+	// an update_record() split up, so that the middle part can run on the
+	// worker pool. only _compute_record() runs off the main thread.
+	struct RecordTask {
+		Cache *record;
+		Bezier2D *shape;
+		Vector2 origin;
+		Vector<real_t> key; // empty with occlusion culling
+		uint32_t hash;
+		IntPolygons fill;
+		IntPolygons stroke;
 		Tesselation tesselation;
 	};
 
+	struct RecordJob {
+		const Tesselator2D *tesselator;
+		RecordTask *tasks;
+	};
+
 	HashMap<NodePath, Cache> cache;
+	HashMap<uint32_t, Instance> instances;
+	HashMap<NodePath, Stored> stored; // loaded with the scene, not yet claimed
 	TesselationParameters parameters;
 
 	bool meld_dirty;
 
+	bool occlusion_culling;
+	bool occlusion_dirty;
+
+	bool store_tesselation;
+
+	enum MeldStage {
+		MELD_FILL,
+		MELD_LOCK,
+		MELD_SIMPLIFY
+	};
+
+	struct MeldShape {
+		NodePath path;
+		ClipperLib::Path locked;
+		ClipperLib::IntRect bounds; // of all points simplify can see, stroke included
+		bool empty;
+	};
+
+	bool melding; // true while a meld is in progress
+	MeldStage meld_stage;
+	Vector<NodePath> meld_queue;
+	Vector<MeldShape> meld_shapes;
+	struct MeldGroup; // shapes that meld together, see _partition_meld()
+	struct MeldItem;
+	struct MeldTask;
+	struct MeldJob;
+
+	Vector<MeldGroup *> meld_groups; // NULL once finished
+	int meld_cursor; // into meld_queue, or the first unfinished group
+
+	int budget_usec; // per frame, 0 means everything is done on demand
+	bool stepping; // true while work is spread over frames
+	float canvas_scale; // as of the last frame, see _canvas_scale_changed()
+
+	float hairline_width;
+	float fringe_width; // in screen pixels
+	float cull_size; // in pixels, smaller shapes are not tesselated
+
 	float get_detail() const;
+	void release_instance(Cache *p_record);
 	void update_record(Cache *p_record);
-	void update_tesselation(Tesselation &r_tesselation, const IntPolygons &p_fill, const IntPolygons &p_stroke) const;
-	void compute_meld();
+	bool _begin_record(Cache *p_record, RecordTask &r_task);
+	void _compute_record(RecordTask &r_task) const;
+	void _end_record(RecordTask &p_task);
+	void _update_records();
+	static void _record_worker(void *p_job, int p_index);
+	void cull_record(Cache *p_record, const Bezier2D *p_shape);
+	void update_tesselation(Tesselation &r_tesselation, const Bezier2D *p_shape, const IntPolygons &p_fill, const IntPolygons &p_stroke, const IntPolygons &p_outline) const;
+	void _begin_meld();
+	void _end_meld();
+	bool _step_meld(uint64_t p_deadline);
+	void _fill_meld();
+	void _partition_meld();
+	void _split_meld(const Vector<int> &p_component);
+	void _clear_meld_groups();
+	void _simplify_meld(bool p_budget);
+	static void _meld_worker(void *p_job, int p_index);
+	bool _step(uint64_t p_deadline);
+	void compute_occlusion();
+	void _validate();
 	void _refresh();
+	float _get_canvas_scale() const;
+	void _canvas_scale_changed();
+
+	void _get_input_key(const Bezier2D *p_shape, Vector<real_t> &r_key) const;
+	void _set_cache(const Array &p_cache);
+	Array _get_cache();
 
 protected:
+	void _notification(int p_what);
+	virtual void _validate_property(PropertyInfo &property) const;
 	static void _bind_methods();
 
 public:
 	void register_shape(const NodePath &p_path);
 	void deregister_shape(const NodePath &p_path);
 	void mark_dirty(const NodePath &p_path);
+	void invalidate_record(const NodePath &p_path);
+	void mark_paint_dirty();
+
+	void tesselate();
+	Dictionary get_statistics() const;
 
 	void get_tesselation(const NodePath &p_path, Tesselation &r_tesselation);
 	Rect2 get_edit_rect(const NodePath &p_path);
+	Polygons get_collision_polygons(const NodePath &p_path, float p_tolerance, bool p_convex);
+	Vector<Vector2> simplify_outline(const Vector<Vector2> &p_points) const;
+	Vector<int> triangulate_matched(const Polygons &p_polygons, bool p_evenodd) const;
 
 	void set_quality(float p_quality);
 	float get_quality() const;
@@ -68,7 +239,26 @@ public:
 	void set_meld(bool p_meld);
 	bool get_meld() const;
 
+	void set_occlusion_culling(bool p_enabled);
+	bool get_occlusion_culling() const;
+
+	void set_store_tesselation(bool p_enabled);
+	bool get_store_tesselation() const;
+
+	void set_budget(int p_usec);
+	int get_budget() const;
+
+	void set_hairline_width(float p_width);
+	float get_hairline_width() const;
+
+	void set_fringe_width(float p_width);
+	float get_fringe_width() const;
+
+	void set_cull_size(float p_size);
+	float get_cull_size() const;
+
 	Tesselator2D();
+	~Tesselator2D();
 };
 
 #endif // TESSELATOR_2D_H
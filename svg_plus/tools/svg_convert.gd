@@ -0,0 +1,30 @@
+# converts SVGs to PNGs and pre-tesselated scenes without opening the editor:
+#
+#   godot --no-window -s svg_convert.gd manifest.json
+#
+# see svg_batch.cpp for the manifest's format.
+
+extends SceneTree
+
+var done = false
+
+func _idle(delta):
+	if done:
+		return true
+	done = true
+
+	var args = OS.get_cmdline_args()
+	if args.size() < 1 or not args[args.size() - 1].ends_with(".json"):
+		printerr("usage: godot --no-window -s svg_convert.gd manifest.json")
+		return true
+
+	var converter = SVGBatchConverter.new()
+	var result = converter.convert(args[args.size() - 1], get_root())
+	if result.empty():
+		return true
+
+	print("converted %d, skipped %d, failed %d" % [result.converted, result.skipped, result.failed])
+	for input in result.failures:
+		printerr("failed: " + input)
+
+	return true